@@ -10,6 +10,12 @@ echo "mdev hotplug: ACTION=$ACTION DEVICE=$MDEV" >> /tmp/usb-hotplug.log
 # Skip internal I2S card
 [ "$MDEV" = "card0" ] && exit 0
 
+# With the router's play server on, S95* players feed uac2_play and never
+# open a card themselves: leave them running, the router owns the outputs
+router_owns_output() {
+    [ -x /usr/bin/uac2_router ] && ! grep -q '^PLAY_CLIENTS=0' /etc/uac2_router.conf 2>/dev/null
+}
+
 case "$ACTION" in
     add)
         # USB audio device connected
@@ -17,12 +23,18 @@ case "$ACTION" in
         sleep 1
         # Stop then start audio services (cleaner than restart)
         /etc/init.d/S01statusmonitor restart
-        for service in /etc/init.d/S95*; do
-            if [ -x "$service" ]; then
-                "$service" stop
-                "$service" start &
-            fi
-        done
+        if ! router_owns_output; then
+            for service in /etc/init.d/S95*; do
+                if [ -x "$service" ]; then
+                    "$service" stop
+                    "$service" start &
+                fi
+            done
+        fi
+        # Router with a USB output sink: re-probe the DAC
+        if grep -q '^SINKS=.*usb' /etc/uac2_router.conf 2>/dev/null; then
+            /usr/bin/uac2_router ctl reconfigure >/dev/null 2>&1 &
+        fi
         ;;
     remove)
         # USB audio device disconnected
@@ -30,8 +42,12 @@ case "$ACTION" in
 
         # Stop audio services to prevent 100% CPU usage (especially librespot)
         # They will be restarted when USB device is reconnected
-        for service in /etc/init.d/S95*; do
-            [ -x "$service" ] && "$service" stop &
-        done
+        if ! router_owns_output; then
+            for service in /etc/init.d/S95*; do
+                [ -x "$service" ] && "$service" stop &
+            done
+        elif grep -q '^SINKS=.*usb' /etc/uac2_router.conf 2>/dev/null; then
+            /usr/bin/uac2_router ctl reconfigure >/dev/null 2>&1 &
+        fi
         ;;
 esac
\ No newline at end of file
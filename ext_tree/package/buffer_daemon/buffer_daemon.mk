@@ -4,7 +4,7 @@
 #
 ################################################################################
 
-BUFFER_DAEMON_VERSION = 1.0
+BUFFER_DAEMON_VERSION = 1.1
 BUFFER_DAEMON_SITE = $(TOPDIR)/../ext_tree/package/buffer_daemon/src
 BUFFER_DAEMON_SITE_METHOD = local
 BUFFER_DAEMON_LICENSE = MIT
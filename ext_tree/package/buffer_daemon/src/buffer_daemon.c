@@ -3,69 +3,158 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
 #include <alsa/asoundlib.h>
 #include <time.h>
 
+#define SYSFS_UAC2_PATH    "/sys/class/u_audio"
+#define I2S_CARD_DEFAULT   0
 #define BUFFER_AVG_SAMPLES 50   /* 5 seconds at 10Hz */
+#define SAMPLE_INTERVAL_MS 100  /* target, rounded to whole periods */
+#define IDLE_INTERVAL_MS   1000 /* playback closed: only look for a start */
+#define DISCOVERY_RETRY_S  1
 
 static double buffer_history[BUFFER_AVG_SAMPLES];
 static int buffer_history_index = 0;
 static int buffer_history_filled = 0;
-static unsigned int current_rate = 768000;
+static unsigned int current_rate = 0;
 static int verbose_logging = 0;  /* Default: no logging */
 
+/* Opened once, read with pread() from offset 0 on every sample */
+static int feedback_fd = -1;
+static int rate_fd = -1;
+static int status_fd = -1;
+static int hw_params_fd = -1;
+static int timer_fd = -1;
+
+/* Playback stream as negotiated by whoever owns the I2S card */
+struct hw_params {
+    int valid;
+    unsigned int rate;
+    long period_size;
+    long buffer_size;
+};
+
+static struct hw_params params;
+static long interval_ns;
+
+/* ── Device discovery ─────────────────────────────────────────────── */
+
+/* Same lookup as uac2_router: the gadget registers uac_card<N> under
+ * /sys/class/u_audio, N being its ALSA card number */
+static int find_uac_card(char *path, size_t size) {
+    struct stat st;
+    for (int i = 0; i < 10; i++) {
+        snprintf(path, size, "%s/uac_card%d", SYSFS_UAC2_PATH, i);
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode))
+            return i;
+    }
+    return -1;
+}
+
+static int open_file(const char *dir, const char *name, int flags) {
+    char path[320];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, flags | O_CLOEXEC);
+    if (fd < 0)
+        fprintf(stderr, "[INIT] Cannot open %s: %s\n", path, strerror(errno));
+    return fd;
+}
+
+/* Whole file from the start; sysfs and procfs regenerate it per read */
+static int read_fd(int fd, char *buf, size_t size) {
+    ssize_t len = pread(fd, buf, size - 1, 0);
+    if (len < 0) return -1;
+    buf[len] = '\0';
+    return 0;
+}
+
+/* ── Feedback and rate (gadget sysfs) ─────────────────────────────── */
+
 static int send_feedback(unsigned int feedback_value) {
-    FILE *fp = fopen("/sys/devices/virtual/u_audio/uac_card1/feedback", "w");
-    if (!fp) {
-        if (verbose_logging) printf("[FEEDBACK] Cannot open feedback sysfs\n");
+    char buf[16];
+    int len = snprintf(buf, sizeof(buf), "%u\n", feedback_value);
+
+    if (pwrite(feedback_fd, buf, len, 0) != len) {
+        if (verbose_logging) printf("[FEEDBACK] Cannot write feedback sysfs: %s\n", strerror(errno));
         return -1;
     }
-    
-    fprintf(fp, "%u\n", feedback_value);
-    fclose(fp);
-    
     return 0;
 }
 
-static void read_rate_from_sysfs() {
-    FILE *fp = fopen("/sys/devices/virtual/u_audio/uac_card1/rate", "r");
-    if (fp) {
-        unsigned int rate;
-        if (fscanf(fp, "%u", &rate) == 1) {
-            if (rate != current_rate) {
-                if (verbose_logging) printf("[RATE] Changed from %u to %u Hz\n", current_rate, rate);
-                current_rate = rate;
-            }
-        }
-        fclose(fp);
+/* Also re-arms POLLPRI: sysfs only notifies again after a read */
+static int read_rate_from_sysfs(void) {
+    char buf[32];
+    unsigned int rate;
+
+    if (read_fd(rate_fd, buf, sizeof(buf)) < 0 || sscanf(buf, "%u", &rate) != 1)
+        return 0;
+    if (rate == current_rate)
+        return 0;
+    if (verbose_logging) printf("[RATE] Changed from %u to %u Hz\n", current_rate, rate);
+    current_rate = rate;
+    return 1;
+}
+
+/* ── Playback status (I2S card procfs) ────────────────────────────── */
+
+static void read_hw_params(void) {
+    char buf[512], *line;
+
+    params.valid = 0;
+    if (read_fd(hw_params_fd, buf, sizeof(buf)) < 0 || strncmp(buf, "closed", 6) == 0)
+        return;
+
+    for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+        sscanf(line, "rate: %u", &params.rate);
+        sscanf(line, "period_size: %ld", &params.period_size);
+        sscanf(line, "buffer_size: %ld", &params.buffer_size);
     }
+    params.valid = params.rate > 0 && params.period_size > 0 &&
+                   params.buffer_size >= params.period_size;
+    if (params.valid && verbose_logging)
+        printf("[PARAMS] rate=%u period=%ld buffer=%ld\n",
+               params.rate, params.period_size, params.buffer_size);
 }
 
 static int read_buffer_status(long *avail, long *buffer_size, long *delay) {
-    FILE *fp = fopen("/proc/asound/card0/pcm0p/sub0/status", "r");
-    if (!fp) {
+    char buf[1024], *line;
+
+    if (read_fd(status_fd, buf, sizeof(buf)) < 0)
+        return -1;
+
+    /* "closed", or open but not moving: the stream geometry may change
+     * before it runs again */
+    if (!strstr(buf, "state: RUNNING")) {
+        params.valid = 0;
         return -1;
     }
+    if (!params.valid) {
+        read_hw_params();
+        if (!params.valid)
+            return -1;
+    }
 
-    char line[256];
     *avail = -1;
-    *buffer_size = 16384; /* Default from hw_params */
+    *buffer_size = params.buffer_size;
     *delay = -1;
 
-    while (fgets(line, sizeof(line), fp)) {
+    for (line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
         if (strstr(line, "avail")) {
             sscanf(line, "avail       : %ld", avail);
         } else if (strstr(line, "delay")) {
             sscanf(line, "delay       : %ld", delay);
         }
     }
-    fclose(fp);
 
     /* Filter out invalid values */
     if (*avail < 0 || *avail > *buffer_size) {
         return -1;
     }
-    
+
     if (*delay < 0 || *delay > (*buffer_size * 2)) {
         return -1;
     }
@@ -73,9 +162,44 @@ static int read_buffer_status(long *avail, long *buffer_size, long *delay) {
     return 0;
 }
 
+/* ── Sampling interval ────────────────────────────────────────────── */
+
+/*
+ * The fill is a sawtooth at the period rate; sampling at a whole number
+ * of periods keeps it at the same phase every time, so it does not
+ * alias into the average.  ~SAMPLE_INTERVAL_MS while playing, one slow
+ * tick while closed.
+ */
+static void set_interval(void) {
+    long ns = IDLE_INTERVAL_MS * 1000000L;
+
+    if (params.valid) {
+        double period_ms = params.period_size * 1000.0 / params.rate;
+        long periods = (long)(SAMPLE_INTERVAL_MS / period_ms + 0.5);
+        if (periods < 1) periods = 1;
+        ns = (long)(periods * period_ms * 1e6);
+    }
+    if (ns == interval_ns)
+        return;
+    interval_ns = ns;
+
+    struct itimerspec its = {
+        .it_interval = { ns / 1000000000, ns % 1000000000 },
+        .it_value    = { ns / 1000000000, ns % 1000000000 },
+    };
+    timerfd_settime(timer_fd, 0, &its, NULL);
+    if (verbose_logging) printf("[TIMER] Sampling every %.2f ms\n", ns / 1e6);
+}
+
+static void reset_history(void) {
+    buffer_history_index = 0;
+    buffer_history_filled = 0;
+}
+
 void print_usage(const char *prog_name) {
     printf("Usage: %s [OPTIONS]\n", prog_name);
     printf("Options:\n");
+    printf("  -c, --card N     I2S playback card (default: %d)\n", I2S_CARD_DEFAULT);
     printf("  -v, --verbose    Enable verbose logging (default: disabled)\n");
     printf("  -h, --help       Show this help message\n");
     printf("\n");
@@ -84,10 +208,14 @@ void print_usage(const char *prog_name) {
 }
 
 int main(int argc, char *argv[]) {
+    int i2s_card = I2S_CARD_DEFAULT;
+
     /* Parse command line arguments */
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--verbose") == 0) {
             verbose_logging = 1;
+        } else if ((strcmp(argv[i], "-c") == 0 || strcmp(argv[i], "--card") == 0) && i + 1 < argc) {
+            i2s_card = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -100,46 +228,88 @@ int main(int argc, char *argv[]) {
 
     if (verbose_logging) {
         printf("═══════════════════════════════════════════════════════\n");
-        printf("  Buffer Monitoring Daemon v4.0\n");
+        printf("  Buffer Monitoring Daemon v5.0\n");
         printf("  Filters: ignore empty/invalid values\n");
         printf("  Verbose logging: ENABLED\n");
         printf("═══════════════════════════════════════════════════════\n");
         printf("Starting buffer monitoring with %d sample averaging...\n", BUFFER_AVG_SAMPLES);
     }
 
-    /* Main buffer monitoring loop */
+    /* The gadget appears once the UDC binds; wait for it */
+    char uac_path[256], proc_path[64];
+    int uac_card;
+    while ((uac_card = find_uac_card(uac_path, sizeof(uac_path))) < 0)
+        sleep(DISCOVERY_RETRY_S);
+    snprintf(proc_path, sizeof(proc_path), "/proc/asound/card%d/pcm0p/sub0", i2s_card);
+    if (verbose_logging) printf("[INIT] Gadget %s (card %d), playback %s\n", uac_path, uac_card, proc_path);
+
+    feedback_fd  = open_file(uac_path, "feedback", O_WRONLY);
+    rate_fd      = open_file(uac_path, "rate", O_RDONLY);
+    status_fd    = open_file(proc_path, "status", O_RDONLY);
+    hw_params_fd = open_file(proc_path, "hw_params", O_RDONLY);
+    timer_fd     = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (feedback_fd < 0 || rate_fd < 0 || status_fd < 0 || hw_params_fd < 0 || timer_fd < 0)
+        return 1;
+
+    read_rate_from_sysfs();
+    set_interval();
+
+    struct pollfd pfd[2] = {
+        { .fd = timer_fd, .events = POLLIN },
+        { .fd = rate_fd,  .events = POLLPRI },
+    };
+
+    /* Main buffer monitoring loop: timer ticks and rate notifications */
     while (1) {
-        /* Read current rate */
-        read_rate_from_sysfs();
-        
+        if (poll(pfd, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "[POLL] %s\n", strerror(errno));
+            return 1;
+        }
+
+        /* Host switched rate: the history belongs to the old stream,
+         * the geometry is re-read once playback runs again */
+        if (pfd[1].revents & (POLLPRI | POLLERR)) {
+            if (read_rate_from_sysfs()) {
+                reset_history();
+                params.valid = 0;
+            }
+        }
+
+        if (!(pfd[0].revents & POLLIN))
+            continue;
+        uint64_t expirations;
+        if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+            continue;
+
         /* Read buffer status with filtering */
         long avail, buffer_size, delay;
-        if (read_buffer_status(&avail, &buffer_size, &delay) < 0) {
+        int status = read_buffer_status(&avail, &buffer_size, &delay);
+        set_interval();
+        if (status < 0) {
             if (verbose_logging) printf("[FILTER] Invalid buffer status - skipping\n");
-            usleep(100000); /* 100ms */
             continue;
         }
 
         /* Additional filtering: skip if delay is 0 or avail is buffer_size (empty) */
         if (delay == 0 || avail == buffer_size) {
             if (verbose_logging) printf("[FILTER] Empty buffer (delay=%ld, avail=%ld) - skipping\n", delay, avail);
-            usleep(100000); /* 100ms */
             continue;
         }
 
         /* Calculate current buffer fill ratio */
         double current_fill = (double)(buffer_size - avail) / buffer_size;
-        
+
         /* Add to history buffer */
         buffer_history[buffer_history_index] = current_fill;
         buffer_history_index = (buffer_history_index + 1) % BUFFER_AVG_SAMPLES;
-        
+
         if (!buffer_history_filled) {
             if (buffer_history_index == 0) {
                 buffer_history_filled = 1;
             }
         }
-        
+
         /* Calculate average fill ratio */
         double fill_ratio = 0.0;
         int samples = buffer_history_filled ? BUFFER_AVG_SAMPLES : buffer_history_index;
@@ -147,19 +317,19 @@ int main(int argc, char *argv[]) {
             fill_ratio += buffer_history[i];
         }
         fill_ratio /= samples;
-        
-        /* Calculate delay in milliseconds */
-        double delay_ms = (double)delay * 1000.0 / (current_rate * 2 * 4);
-        
+
+        /* Calculate delay in milliseconds (delay is in frames) */
+        double delay_ms = (double)delay * 1000.0 / params.rate;
+
         if (verbose_logging) {
-            printf("[MONITOR] delay=%ld, avail=%ld, size=%ld, current=%.3f, avg=%.3f, delay_ms=%.2f\n", 
+            printf("[MONITOR] delay=%ld, avail=%ld, size=%ld, current=%.3f, avg=%.3f, delay_ms=%.2f\n",
                    delay, avail, buffer_size, current_fill, fill_ratio, delay_ms);
         }
-        
+
 /* Feedback control with hysteresis and gradual adjustment */
         static unsigned int current_feedback = 1000000;
         unsigned int target_feedback = current_feedback;
-        
+
         /* Hysteresis zones with overlap to prevent oscillation */
         if (fill_ratio > 0.65) {
             /* Buffer very high - need slowdown */
@@ -186,12 +356,12 @@ int main(int argc, char *argv[]) {
             target_feedback = 1000000;
             if (verbose_logging) printf("[ACTION] Buffer good (%.3f) - target %u\n", fill_ratio, target_feedback);
         }
-        
+
         /* Gradual adjustment - max 0.02% change per cycle for ultra-smooth control */
         if (target_feedback != current_feedback) {
             int max_change = 200; /* 0.02% of 1000000 - reduced from 500 for even slower changes */
             int feedback_diff = target_feedback - current_feedback;
-            
+
             if (feedback_diff > max_change) {
                 current_feedback += max_change;
                 if (verbose_logging) printf("[GRADUAL] Increase to %u (+%d)\n", current_feedback, max_change);
@@ -205,11 +375,9 @@ int main(int argc, char *argv[]) {
         } else {
             if (verbose_logging) printf("[GRADUAL] Maintain %u (no change)\n", current_feedback);
         }
-        
+
         send_feedback(current_feedback);
-        
-        usleep(100000); /* 100ms = 10Hz sampling */
     }
 
     return 0;
-}
\ No newline at end of file
+}
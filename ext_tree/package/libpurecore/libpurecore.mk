@@ -0,0 +1,61 @@
+################################################################################
+#
+# libpurecore
+#
+################################################################################
+
+LIBPURECORE_VERSION = 1.1
+LIBPURECORE_SITE = $(TOPDIR)/../ext_tree/package/libpurecore/src
+LIBPURECORE_SITE_METHOD = local
+LIBPURECORE_LICENSE = MIT
+LIBPURECORE_LICENSE_FILES = LICENSE
+LIBPURECORE_DEPENDENCIES = alsa-lib
+LIBPURECORE_INSTALL_STAGING = YES
+
+# The toolchain defaults to vfpv4-d16; the kernels in swap.c use NEON
+ifeq ($(BR2_ARM_CPU_HAS_NEON),y)
+LIBPURECORE_CFLAGS = -mfpu=neon-vfpv4
+endif
+
+LIBPURECORE_SOURCES = dsd.c clock.c period.c swap.c drift.c version.c pcm_alsa.c pcm_direct.c
+
+define LIBPURECORE_BUILD_CMDS
+	$(TARGET_CC) $(TARGET_CFLAGS) $(LIBPURECORE_CFLAGS) -Wall -fPIC -shared \
+		-I$(@D) -Wl,-soname,libpurecore.so.1 -o $(@D)/libpurecore.so.1 \
+		$(addprefix $(@D)/,$(LIBPURECORE_SOURCES)) $(TARGET_LDFLAGS) -lasound -lm
+endef
+
+define LIBPURECORE_INSTALL_STAGING_CMDS
+	$(INSTALL) -d $(STAGING_DIR)/usr/include/purecore
+	$(INSTALL) -m 0644 $(@D)/purecore/*.h $(STAGING_DIR)/usr/include/purecore/
+	$(INSTALL) -D -m 0755 $(@D)/libpurecore.so.1 $(STAGING_DIR)/usr/lib/libpurecore.so.1
+	ln -sf libpurecore.so.1 $(STAGING_DIR)/usr/lib/libpurecore.so
+endef
+
+define LIBPURECORE_INSTALL_TARGET_CMDS
+	$(INSTALL) -D -m 0755 $(@D)/libpurecore.so.1 $(TARGET_DIR)/usr/lib/libpurecore.so.1
+endef
+
+# Host side: "make host-libpurecore" builds and runs the unit tests for
+# everything that does not need a sound card, and the drift estimator's
+# convergence bench (table in purecore/drift.h)
+HOST_LIBPURECORE_DEPENDENCIES =
+HOST_LIBPURECORE_TEST_SOURCES = dsd.c clock.c period.c swap.c drift.c version.c
+
+define HOST_LIBPURECORE_BUILD_CMDS
+	$(HOSTCC) $(HOST_CFLAGS) -Wall -I$(@D) -o $(@D)/test_purecore \
+		$(@D)/tests/test_purecore.c \
+		$(addprefix $(@D)/,$(HOST_LIBPURECORE_TEST_SOURCES)) $(HOST_LDFLAGS) -lm
+	$(HOSTCC) $(HOST_CFLAGS) -Wall -I$(@D) -o $(@D)/drift_bench \
+		$(@D)/bench/drift_bench.c $(@D)/drift.c $(HOST_LDFLAGS) -lm
+	$(@D)/test_purecore
+	$(@D)/drift_bench
+endef
+
+define HOST_LIBPURECORE_INSTALL_CMDS
+	$(INSTALL) -D -m 0755 $(@D)/test_purecore $(HOST_DIR)/bin/test_purecore
+	$(INSTALL) -D -m 0755 $(@D)/drift_bench $(HOST_DIR)/bin/drift_bench
+endef
+
+$(eval $(generic-package))
+$(eval $(host-generic-package))
@@ -0,0 +1,143 @@
+/*
+ * drift_bench — convergence of the drift estimator (purecore/drift.h)
+ *
+ * Closed-loop simulation, no hardware: a host clock off by an unknown
+ * offset feeds a buffer drained by the DAC clock; the estimator sees the
+ * fill every ~100 ms (with scheduling jitter and sampling noise) and its
+ * pitch goes back through integer ppm and the high-speed Q16.16 wire
+ * format.  Per rate, two segments:
+ *
+ *   0–60 s     offset +100 ppm, estimator starts from 0
+ *   60–120 s   offset steps to −50 ppm (worst case: temperature jump)
+ *
+ * The fill is sampled with 0.5 ms of noise.  Reported per segment:
+ * settle time (|fill error| below 0.25 ms of audio for good), offset
+ * estimate error at the end and RMS fill error over the last 30 s.
+ * Exit status is non-zero if any rate misses the bounds below.
+ *
+ *   drift_bench [-s seed] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "purecore/drift.h"
+
+#define SEGMENT_S       60.0
+#define SAMPLE_S        0.1
+#define SIM_STEP_S      0.001       /* plant integration, one USB frame */
+
+/* Pass bounds.  The offset bound is the HS wire resolution at 44.1k
+ * (1 / (5.5125 · 65536) ≈ 2.8 ppm) plus margin, the estimate cannot do
+ * better than what the host is told. */
+#define SETTLE_MAX_S    30.0
+#define OFFSET_MAX_PPM  5.0
+#define RMS_MAX_MS      0.25
+
+static uint64_t rng = 0x9E3779B97F4A7C15ULL;
+
+static double uniform(void) {
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (rng >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double gauss(void) {
+    double u1 = uniform(), u2 = uniform();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/* What the host actually gets: pitch → HS feedback value (Q16.16
+ * samples per microframe) → effective offset, ppm */
+static double wire_ppm(unsigned int rate, unsigned int pitch) {
+    double nominal = rate / 8000.0 * 65536.0;
+    double ff = floor(nominal * pitch / 1e6 + 0.5);
+    return (ff / nominal - 1.0) * 1e6;
+}
+
+struct segment {
+    double settle_s;            /* -1: never */
+    double offset_err;          /* |d̂ − d| at the end, ppm */
+    double rms_ms;              /* fill error, last 30 s */
+};
+
+static void run(unsigned int rate, struct segment seg[2], int verbose) {
+    struct pc_drift s;
+    const double offsets[2] = { 100.0, -50.0 };
+    const double good = rate / 4000.0;          /* 0.25 ms of audio */
+    const double sigma = rate / 2000.0;         /* sampling noise, 0.5 ms */
+    double fill = 0.0, u_wire = 0.0, t = 0.0, next_sample = 0.0;
+
+    pc_drift_init(&s, rate, 0.0);
+    memset(seg, 0, 2 * sizeof(seg[0]));
+
+    for (int k = 0; k < 2; k++) {
+        double end = (k + 1) * SEGMENT_S, last_bad = k * SEGMENT_S;
+        double sumsq = 0.0;
+        long n = 0;
+
+        for (; t < end; t += SIM_STEP_S) {
+            fill += (offsets[k] + u_wire) * rate * 1e-6 * SIM_STEP_S;
+            if (fabs(fill) >= good) last_bad = t;
+            if (t >= end - 30.0) { sumsq += fill * fill; n++; }
+
+            if (t >= next_sample) {
+                uint64_t t_ns = (uint64_t)((t + 1.0) * 1e9);     /* 0 is "none" */
+                double u = pc_drift_update(&s, t_ns, fill + sigma * gauss());
+                unsigned int pitch = pc_drift_quantize(&s, PC_DRIFT_PITCH_NOMINAL - u);
+                /* Pitch below nominal slows the host: u_wire < 0 */
+                u_wire = wire_ppm(rate, pitch);
+                next_sample = t + SAMPLE_S + (uniform() - 0.5) * 0.01;
+                if (verbose && fmod(t, 1.0) < SAMPLE_S)
+                    printf("  %6u t=%5.1f fill=%8.1f d=%8.3f u=%8.3f pitch=%u\n",
+                           rate, t, fill, s.d, u, pitch);
+            }
+        }
+        seg[k].settle_s   = last_bad >= end - SIM_STEP_S ? -1.0 : last_bad - k * SEGMENT_S;
+        seg[k].offset_err = fabs(s.d - offsets[k]);
+        seg[k].rms_ms     = sqrt(sumsq / (n ? n : 1)) * 1000.0 / rate;
+    }
+}
+
+int main(int argc, char **argv) {
+    static const unsigned int rates[] = {
+        44100, 48000, 96000, 192000, 384000, 705600, 768000,
+    };
+    int opt, verbose = 0, failed = 0;
+
+    while ((opt = getopt(argc, argv, "s:v")) != -1) {
+        switch (opt) {
+        case 's': rng = strtoull(optarg, NULL, 0) * 0x9E3779B97F4A7C15ULL | 1; break;
+        case 'v': verbose = 1; break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%-8s | %-28s | %-28s\n", "", "+100 ppm from 0", "step to -50 ppm");
+    printf("%-8s | %8s %9s %9s | %8s %9s %9s\n", "rate",
+           "settle", "off.err", "rms", "settle", "off.err", "rms");
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        struct segment seg[2];
+
+        run(rates[i], seg, verbose);
+        printf("%-8u |", rates[i]);
+        for (int k = 0; k < 2; k++) {
+            if (seg[k].settle_s < 0) printf("   never ");
+            else printf(" %6.1f s", seg[k].settle_s);
+            printf(" %5.2f ppm %6.3f ms%s", seg[k].offset_err, seg[k].rms_ms, k ? "\n" : " |");
+            if (seg[k].settle_s < 0 || seg[k].settle_s > SETTLE_MAX_S ||
+                seg[k].offset_err > OFFSET_MAX_PPM || seg[k].rms_ms > RMS_MAX_MS)
+                failed = 1;
+        }
+    }
+    printf("%s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
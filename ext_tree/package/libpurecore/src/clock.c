@@ -0,0 +1,32 @@
+/*
+ * Clock families — see purecore/clock.h
+ */
+
+#include "purecore/clock.h"
+#include "purecore/dsd.h"
+
+enum pc_clock_family pc_clock_family(unsigned int rate) {
+    unsigned int lrck = pc_lrck_rate(rate);
+
+    if (lrck == 0) return PC_FAMILY_NONE;
+    if (lrck % 11025 == 0) return PC_FAMILY_44K1;
+    if (lrck % 8000 == 0) return PC_FAMILY_48K;
+    return PC_FAMILY_NONE;
+}
+
+const char *pc_clock_family_name(enum pc_clock_family family) {
+    switch (family) {
+    case PC_FAMILY_44K1: return "44.1k";
+    case PC_FAMILY_48K:  return "48k";
+    default:             return "none";
+    }
+}
+
+unsigned long pc_mclk_hz(unsigned int rate, unsigned int multiplier) {
+    return (unsigned long)pc_lrck_rate(rate) * multiplier;
+}
+
+int pc_same_clock(unsigned int rate_a, unsigned int rate_b) {
+    return pc_lrck_rate(rate_a) == pc_lrck_rate(rate_b) &&
+           pc_is_dsd_rate(rate_a) == pc_is_dsd_rate(rate_b);
+}
@@ -0,0 +1,102 @@
+/*
+ * Clock drift estimator — see purecore/drift.h
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "purecore/drift.h"
+
+#define DRIFT_PPM_PRIOR     200.0   /* σ of an unknown offset, ppm */
+#define DRIFT_DT_MAX        1.0     /* longer gaps restart the fill */
+#define DRIFT_BIAS_ALPHA    0.1     /* innovation mean, ~1 s */
+#define DRIFT_BIAS_MAX      0.7     /* in σ: ~5× its own noise */
+
+void pc_drift_init(struct pc_drift *s, unsigned int lrck_rate, double offset_ppm) {
+    memset(s, 0, sizeof(*s));
+    s->rate = lrck_rate;
+    s->tau  = PC_DRIFT_TAU_S;
+
+    /* Sampling jitter: USB data lands per request and the sample point
+     * wobbles against it; ~1 ms of data covers it */
+    double sigma = lrck_rate / 1000.0;
+    s->r       = sigma * sigma;
+    s->q_fill  = s->r * 1e-4;       /* the model is exact up to the pitch rounding */
+    s->q_drift = 0.01;              /* crystals wander slowly */
+
+    s->d = offset_ppm;
+    s->p[1][1] = offset_ppm != 0.0 ? 10.0 * 10.0 : DRIFT_PPM_PRIOR * DRIFT_PPM_PRIOR;
+}
+
+void pc_drift_reset_fill(struct pc_drift *s) {
+    s->last_ns = 0;
+    s->bias = 0.0;
+}
+
+static double control(struct pc_drift *s) {
+    double u = s->d + s->e / (s->tau * s->rate * 1e-6);
+
+    if (u > PC_DRIFT_PPM_MAX)  u = PC_DRIFT_PPM_MAX;
+    if (u < -PC_DRIFT_PPM_MAX) u = -PC_DRIFT_PPM_MAX;
+    s->u = u;
+    return u;
+}
+
+double pc_drift_update(struct pc_drift *s, uint64_t t_ns, double err) {
+    double dt = s->last_ns ? (double)(t_ns - s->last_ns) * 1e-9 : 0.0;
+
+    if (!s->last_ns || dt <= 0.0 || dt > DRIFT_DT_MAX) {
+        /* First sample (or a gap): take the fill as measured, keep d */
+        s->e = err;
+        s->p[0][0] = s->r;
+        s->p[0][1] = s->p[1][0] = 0.0;
+        s->last_ns = t_ns;
+        return control(s);
+    }
+    s->last_ns = t_ns;
+
+    /* Predict: the fill integrates the net offset over dt */
+    double g = s->rate * 1e-6 * dt;
+    s->e += (s->d - s->u) * g;
+
+    double p00 = s->p[0][0] + g * (s->p[1][0] + s->p[0][1]) + g * g * s->p[1][1]
+               + s->q_fill * dt;
+    double p01 = s->p[0][1] + g * s->p[1][1];
+    double p11 = s->p[1][1] + s->q_drift * dt;
+
+    /* Update with the measured fill */
+    double y  = err - s->e;
+
+    /*
+     * A clean model trusts d̂ more every second and would take minutes to
+     * follow a real step (host clock source switched, a cold DAC warming
+     * up).  A persistent one-sided innovation is the sign: forget the
+     * offset and re-acquire as at start.
+     */
+    s->bias += DRIFT_BIAS_ALPHA * (y / sqrt(p00 + s->r) - s->bias);
+    if (fabs(s->bias) > DRIFT_BIAS_MAX) {
+        if (p00 < s->r) p00 = s->r;
+        p01  = 0.0;
+        p11 += DRIFT_PPM_PRIOR * DRIFT_PPM_PRIOR;
+        s->bias = 0.0;
+        s->reacquired++;
+    }
+    double sv = p00 + s->r;
+    double k0 = p00 / sv, k1 = p01 / sv;
+
+    s->e += k0 * y;
+    s->d += k1 * y;
+    s->p[0][0] = (1.0 - k0) * p00;
+    s->p[0][1] = s->p[1][0] = (1.0 - k0) * p01;
+    s->p[1][1] = p11 - k1 * p01;
+
+    return control(s);
+}
+
+unsigned int pc_drift_quantize(struct pc_drift *s, double pitch) {
+    double want = pitch + s->q_acc;
+    double q = floor(want + 0.5);
+
+    s->q_acc = want - q;
+    return (unsigned int)q;
+}
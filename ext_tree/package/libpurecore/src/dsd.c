@@ -0,0 +1,26 @@
+/*
+ * DSD rates and naming — see purecore/dsd.h
+ */
+
+#include "purecore/dsd.h"
+
+int pc_is_dsd_rate(unsigned int rate) {
+    return (rate == PC_DSD64_RATE    || rate == PC_DSD128_RATE    ||
+            rate == PC_DSD256_RATE   || rate == PC_DSD512_RATE    ||
+            rate == PC_DSD64_RATE_48 || rate == PC_DSD128_RATE_48 ||
+            rate == PC_DSD256_RATE_48|| rate == PC_DSD512_RATE_48);
+}
+
+const char *pc_dsd_name(unsigned int rate) {
+    switch (rate) {
+        case PC_DSD64_RATE:     return "DSD64/44.1";
+        case PC_DSD128_RATE:    return "DSD128/44.1";
+        case PC_DSD256_RATE:    return "DSD256/44.1";
+        case PC_DSD512_RATE:    return "DSD512/44.1";
+        case PC_DSD64_RATE_48:  return "DSD64/48";
+        case PC_DSD128_RATE_48: return "DSD128/48";
+        case PC_DSD256_RATE_48: return "DSD256/48";
+        case PC_DSD512_RATE_48: return "DSD512/48";
+        default: return "Unknown";
+    }
+}
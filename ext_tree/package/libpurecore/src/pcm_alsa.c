@@ -0,0 +1,133 @@
+/*
+ * alsa-lib PCM backend — see pcm_io.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <alsa/asoundlib.h>
+
+#include "purecore/pcm_io.h"
+
+struct pcm_alsa {
+    struct pcm_io io;
+    snd_pcm_t *pcm;
+};
+
+#define to_alsa(p) ((struct pcm_alsa *)(p))
+
+static long alsa_readi(struct pcm_io *io, void *buf, unsigned long frames) {
+    return snd_pcm_readi(to_alsa(io)->pcm, buf, frames);
+}
+
+static long alsa_writei(struct pcm_io *io, const void *buf, unsigned long frames) {
+    return snd_pcm_writei(to_alsa(io)->pcm, buf, frames);
+}
+
+static int alsa_prepare(struct pcm_io *io) { return snd_pcm_prepare(to_alsa(io)->pcm); }
+static int alsa_start(struct pcm_io *io)   { return snd_pcm_start(to_alsa(io)->pcm); }
+static int alsa_drop(struct pcm_io *io)    { return snd_pcm_drop(to_alsa(io)->pcm); }
+
+static int alsa_avail_delay(struct pcm_io *io, long *avail, long *delay) {
+    snd_pcm_sframes_t a, d;
+    int err = snd_pcm_avail_delay(to_alsa(io)->pcm, &a, &d);
+    if (err < 0) return err;
+    *avail = a;
+    *delay = d;
+    return 0;
+}
+
+static int alsa_wait(struct pcm_io *io, int timeout_ms) {
+    return snd_pcm_wait(to_alsa(io)->pcm, timeout_ms);
+}
+
+static void alsa_close(struct pcm_io *io) {
+    snd_pcm_drop(to_alsa(io)->pcm);
+    snd_pcm_close(to_alsa(io)->pcm);
+    free(io);
+}
+
+static const struct pcm_io_ops alsa_ops = {
+    .readi       = alsa_readi,
+    .writei      = alsa_writei,
+    .prepare     = alsa_prepare,
+    .start       = alsa_start,
+    .drop        = alsa_drop,
+    .avail_delay = alsa_avail_delay,
+    .wait        = alsa_wait,
+    .close       = alsa_close,
+};
+
+int pcm_alsa_open(struct pcm_io **io, int card, int device, int stream,
+                  const struct pcm_config *cfg)
+{
+    snd_pcm_hw_params_t *hw_params;
+    snd_pcm_sw_params_t *sw_params;
+    snd_pcm_t *pcm;
+    snd_pcm_uframes_t period_size = cfg->period_size;
+    snd_pcm_uframes_t buffer_size = cfg->buffer_size;
+    unsigned int rate = cfg->rate;
+    char device_name[32];
+    int err;
+
+    snprintf(device_name, sizeof(device_name), "hw:%d,%d", card, device);
+
+    if ((err = snd_pcm_open(&pcm, device_name, stream,
+                            cfg->nonblock ? SND_PCM_NONBLOCK : 0)) < 0) {
+        fprintf(stderr, "Cannot open %s: %s\n", device_name, snd_strerror(err));
+        return err;
+    }
+
+    snd_pcm_hw_params_alloca(&hw_params);
+    snd_pcm_hw_params_any(pcm, hw_params);
+    snd_pcm_hw_params_set_access(pcm, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    /* Format is exact (sinks probe several), rate is taken nearest */
+    if ((err = snd_pcm_hw_params_set_format(pcm, hw_params, cfg->format)) < 0) {
+        snd_pcm_close(pcm);
+        return err;
+    }
+    snd_pcm_hw_params_set_channels(pcm, hw_params, cfg->channels);
+    snd_pcm_hw_params_set_rate_near(pcm, hw_params, &rate, 0);
+
+    /* Cap DSD playback period — RV1106 DMA ignores sub-period writes */
+    if (cfg->period_max) {
+        snd_pcm_uframes_t pmax = period_size;
+        snd_pcm_hw_params_set_period_size_max(pcm, hw_params, &pmax, 0);
+    }
+    snd_pcm_hw_params_set_period_size_near(pcm, hw_params, &period_size, 0);
+    snd_pcm_hw_params_set_buffer_size_near(pcm, hw_params, &buffer_size);
+
+    if ((err = snd_pcm_hw_params(pcm, hw_params)) < 0) {
+        fprintf(stderr, "Cannot set hw params for %s: %s\n", device_name, snd_strerror(err));
+        snd_pcm_close(pcm);
+        return err;
+    }
+
+    snd_pcm_hw_params_get_period_size(hw_params, &period_size, 0);
+    snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_size);
+
+    snd_pcm_sw_params_alloca(&sw_params);
+    snd_pcm_sw_params_current(pcm, sw_params);
+    snd_pcm_sw_params_set_start_threshold(pcm, sw_params,
+        cfg->start_threshold ? cfg->start_threshold : buffer_size / 2);
+    snd_pcm_sw_params_set_avail_min(pcm, sw_params, period_size);
+    snd_pcm_sw_params(pcm, sw_params);
+
+    struct pcm_alsa *pa = calloc(1, sizeof(*pa));
+    if (!pa) {
+        snd_pcm_close(pcm);
+        return -ENOMEM;
+    }
+    pa->pcm            = pcm;
+    pa->io.ops         = &alsa_ops;
+    pa->io.stream      = stream;
+    pa->io.rate        = rate;
+    pa->io.format      = cfg->format;
+    pa->io.channels    = cfg->channels;
+    pa->io.period_size = period_size;
+    pa->io.buffer_size = buffer_size;
+    snprintf(pa->io.name, sizeof(pa->io.name), "%s", device_name);
+
+    *io = &pa->io;
+    return 0;
+}
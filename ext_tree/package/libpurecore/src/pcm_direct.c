@@ -0,0 +1,291 @@
+/*
+ * Direct-ioctl PCM backend — see pcm_io.h
+ *
+ * Talks to /dev/snd/pcmC<card>D<dev>[pc] without alsa-lib:
+ *   - hw_params built from precomputed masks/intervals and sent with a
+ *     single SNDRV_PCM_IOCTL_HW_PARAMS (no HW_REFINE round trips)
+ *   - transfers are one READI_FRAMES / WRITEI_FRAMES ioctl each
+ *   - status/control pages are mmapped where the kernel allows it;
+ *     ARM is not cache-coherent for these pages (-ENXIO), so there
+ *     SNDRV_PCM_IOCTL_SYNC_PTR is used, and only when pointers are
+ *     actually needed (avail/delay), never on the transfer path
+ *
+ * alsa-lib on the same hw device adds a SYNC_PTR after every transfer
+ * on ARM plus state queries inside snd_pcm_readi/writei.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sound/asound.h>
+
+#include "purecore/pcm_io.h"
+
+struct pcm_direct {
+    struct pcm_io io;
+    int fd;
+    unsigned long boundary;
+    volatile struct snd_pcm_mmap_status *status;    /* NULL → use sync_ptr */
+    volatile struct snd_pcm_mmap_control *control;
+    struct snd_pcm_sync_ptr sync;
+};
+
+#define to_direct(p) ((struct pcm_direct *)(p))
+
+/* ── hw_params construction ───────────────────────────────────────── */
+
+static struct snd_mask *hw_mask(struct snd_pcm_hw_params *p, int var) {
+    return &p->masks[var - SNDRV_PCM_HW_PARAM_FIRST_MASK];
+}
+
+static struct snd_interval *hw_interval(struct snd_pcm_hw_params *p, int var) {
+    return &p->intervals[var - SNDRV_PCM_HW_PARAM_FIRST_INTERVAL];
+}
+
+static void hw_any(struct snd_pcm_hw_params *p) {
+    memset(p, 0, sizeof(*p));
+    for (int v = SNDRV_PCM_HW_PARAM_FIRST_MASK; v <= SNDRV_PCM_HW_PARAM_LAST_MASK; v++)
+        memset(hw_mask(p, v)->bits, 0xff, sizeof(hw_mask(p, v)->bits));
+    for (int v = SNDRV_PCM_HW_PARAM_FIRST_INTERVAL; v <= SNDRV_PCM_HW_PARAM_LAST_INTERVAL; v++) {
+        hw_interval(p, v)->min = 0;
+        hw_interval(p, v)->max = UINT_MAX;
+    }
+    p->rmask = ~0u;
+}
+
+static void hw_mask_one(struct snd_pcm_hw_params *p, int var, unsigned int val) {
+    struct snd_mask *m = hw_mask(p, var);
+    memset(m->bits, 0, sizeof(m->bits));
+    m->bits[val >> 5] |= 1u << (val & 31);
+}
+
+static void hw_range(struct snd_pcm_hw_params *p, int var,
+                     unsigned int min, unsigned int max, int integer) {
+    struct snd_interval *i = hw_interval(p, var);
+    i->min = min;
+    i->max = max;
+    i->openmin = i->openmax = 0;
+    i->integer = integer;
+}
+
+/* Exact request first.  If the driver rejects it, widen period/buffer
+ * around the request and let the kernel choose (smallest period time,
+ * largest buffer — snd_pcm_hw_params_choose() order). */
+static int direct_hw_params(int fd, const struct pcm_config *cfg,
+                            unsigned long *period, unsigned long *buffer) {
+    struct snd_pcm_hw_params p;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        unsigned long pmin = cfg->period_size, pmax = cfg->period_size;
+        unsigned long bmin = cfg->buffer_size, bmax = cfg->buffer_size;
+        if (attempt) {
+            pmin /= 2;
+            if (!cfg->period_max) pmax *= 2;
+            bmin /= 2;
+            bmax *= 2;
+        }
+
+        hw_any(&p);
+        hw_mask_one(&p, SNDRV_PCM_HW_PARAM_ACCESS, SNDRV_PCM_ACCESS_RW_INTERLEAVED);
+        hw_mask_one(&p, SNDRV_PCM_HW_PARAM_FORMAT, cfg->format);
+        hw_mask_one(&p, SNDRV_PCM_HW_PARAM_SUBFORMAT, SNDRV_PCM_SUBFORMAT_STD);
+        hw_range(&p, SNDRV_PCM_HW_PARAM_CHANNELS, cfg->channels, cfg->channels, 1);
+        hw_range(&p, SNDRV_PCM_HW_PARAM_RATE, cfg->rate, cfg->rate, 1);
+        hw_range(&p, SNDRV_PCM_HW_PARAM_PERIOD_SIZE, pmin, pmax, 1);
+        hw_range(&p, SNDRV_PCM_HW_PARAM_BUFFER_SIZE, bmin, bmax, 1);
+
+        if (ioctl(fd, SNDRV_PCM_IOCTL_HW_PARAMS, &p) == 0) {
+            *period = hw_interval(&p, SNDRV_PCM_HW_PARAM_PERIOD_SIZE)->min;
+            *buffer = hw_interval(&p, SNDRV_PCM_HW_PARAM_BUFFER_SIZE)->min;
+            return 0;
+        }
+    }
+    return -errno;
+}
+
+static int direct_sw_params(struct pcm_direct *pd, unsigned long start_threshold) {
+    struct snd_pcm_sw_params sw;
+    unsigned long buffer = pd->io.buffer_size;
+
+    /* Same boundary alsa-lib uses: largest buffer_size * 2^n below LONG_MAX */
+    pd->boundary = buffer;
+    while (pd->boundary * 2 <= LONG_MAX - buffer)
+        pd->boundary *= 2;
+
+    memset(&sw, 0, sizeof(sw));
+    sw.tstamp_mode       = SNDRV_PCM_TSTAMP_NONE;
+    sw.period_step       = 1;
+    sw.avail_min         = pd->io.period_size;
+    sw.xfer_align        = 1;
+    sw.start_threshold   = start_threshold ? start_threshold : buffer / 2;
+    sw.stop_threshold    = buffer;
+    sw.silence_threshold = 0;
+    sw.silence_size      = 0;
+    sw.boundary          = pd->boundary;
+    sw.proto             = SNDRV_PCM_VERSION;
+
+    return ioctl(pd->fd, SNDRV_PCM_IOCTL_SW_PARAMS, &sw) < 0 ? -errno : 0;
+}
+
+static void direct_map_status(struct pcm_direct *pd) {
+    long page = sysconf(_SC_PAGESIZE);
+    void *st = mmap(NULL, page, PROT_READ, MAP_SHARED, pd->fd, SNDRV_PCM_MMAP_OFFSET_STATUS);
+    if (st == MAP_FAILED) return;
+    void *ct = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_SHARED, pd->fd,
+                    SNDRV_PCM_MMAP_OFFSET_CONTROL);
+    if (ct == MAP_FAILED) {
+        munmap(st, page);
+        return;
+    }
+    pd->status  = st;
+    pd->control = ct;
+}
+
+/* ── Ops ──────────────────────────────────────────────────────────── */
+
+static long direct_readi(struct pcm_io *io, void *buf, unsigned long frames) {
+    struct snd_xferi x = { .result = 0, .buf = buf, .frames = frames };
+    if (ioctl(to_direct(io)->fd, SNDRV_PCM_IOCTL_READI_FRAMES, &x) < 0)
+        return -errno;
+    return x.result;
+}
+
+static long direct_writei(struct pcm_io *io, const void *buf, unsigned long frames) {
+    struct snd_xferi x = { .result = 0, .buf = (void *)buf, .frames = frames };
+    if (ioctl(to_direct(io)->fd, SNDRV_PCM_IOCTL_WRITEI_FRAMES, &x) < 0)
+        return -errno;
+    return x.result;
+}
+
+static int direct_simple(struct pcm_io *io, unsigned long req) {
+    return ioctl(to_direct(io)->fd, req) < 0 ? -errno : 0;
+}
+
+static int direct_prepare(struct pcm_io *io) { return direct_simple(io, SNDRV_PCM_IOCTL_PREPARE); }
+static int direct_start(struct pcm_io *io)   { return direct_simple(io, SNDRV_PCM_IOCTL_START); }
+static int direct_drop(struct pcm_io *io)    { return direct_simple(io, SNDRV_PCM_IOCTL_DROP); }
+
+static int direct_avail_delay(struct pcm_io *io, long *avail, long *delay) {
+    struct pcm_direct *pd = to_direct(io);
+    unsigned long hw, appl;
+    int state;
+
+    if (pd->status) {
+        if (ioctl(pd->fd, SNDRV_PCM_IOCTL_HWSYNC) < 0) return -errno;
+        hw    = pd->status->hw_ptr;
+        appl  = pd->control->appl_ptr;
+        state = pd->status->state;
+    } else {
+        pd->sync.flags = SNDRV_PCM_SYNC_PTR_HWSYNC | SNDRV_PCM_SYNC_PTR_APPL |
+                         SNDRV_PCM_SYNC_PTR_AVAIL_MIN;
+        if (ioctl(pd->fd, SNDRV_PCM_IOCTL_SYNC_PTR, &pd->sync) < 0) return -errno;
+        hw    = pd->sync.s.status.hw_ptr;
+        appl  = pd->sync.c.control.appl_ptr;
+        state = pd->sync.s.status.state;
+    }
+    if (state == SNDRV_PCM_STATE_XRUN) return -EPIPE;
+
+    /* Pointers wrap at boundary */
+    long filled = (io->stream == PCM_IO_PLAYBACK) ? (long)(appl - hw) : (long)(hw - appl);
+    if (filled < 0) filled += pd->boundary;
+
+    *delay = filled;
+    *avail = (io->stream == PCM_IO_PLAYBACK) ? (long)io->buffer_size - filled : filled;
+    return 0;
+}
+
+static int direct_wait(struct pcm_io *io, int timeout_ms) {
+    struct pollfd pfd = {
+        .fd     = to_direct(io)->fd,
+        .events = io->stream == PCM_IO_PLAYBACK ? POLLOUT : POLLIN,
+    };
+    int n = poll(&pfd, 1, timeout_ms);
+    if (n < 0) return -errno;
+    if (n && (pfd.revents & POLLERR)) return -EPIPE;    /* XRUN or not running */
+    return n;
+}
+
+static void direct_close(struct pcm_io *io) {
+    struct pcm_direct *pd = to_direct(io);
+    long page = sysconf(_SC_PAGESIZE);
+
+    ioctl(pd->fd, SNDRV_PCM_IOCTL_DROP);
+    if (pd->status) {
+        munmap((void *)pd->status, page);
+        munmap((void *)pd->control, page);
+    }
+    close(pd->fd);
+    free(pd);
+}
+
+static const struct pcm_io_ops direct_ops = {
+    .readi       = direct_readi,
+    .writei      = direct_writei,
+    .prepare     = direct_prepare,
+    .start       = direct_start,
+    .drop        = direct_drop,
+    .avail_delay = direct_avail_delay,
+    .wait        = direct_wait,
+    .close       = direct_close,
+};
+
+int pcm_direct_open(struct pcm_io **io, int card, int device, int stream,
+                    const struct pcm_config *cfg)
+{
+    char path[48];
+    unsigned long period, buffer;
+    int err;
+
+    snprintf(path, sizeof(path), "/dev/snd/pcmC%dD%d%c", card, device,
+             stream == PCM_IO_CAPTURE ? 'c' : 'p');
+
+    int fd = open(path, O_RDWR | O_CLOEXEC | (cfg->nonblock ? O_NONBLOCK : 0));
+    if (fd < 0) {
+        err = -errno;
+        fprintf(stderr, "Cannot open %s: %s\n", path, strerror(errno));
+        return err;
+    }
+
+    /* Tell the kernel which protocol we speak (enables appl_ptr sync) */
+    int pver = SNDRV_PCM_VERSION;
+    ioctl(fd, SNDRV_PCM_IOCTL_USER_PVERSION, &pver);
+
+    if ((err = direct_hw_params(fd, cfg, &period, &buffer)) < 0) {
+        fprintf(stderr, "Cannot set hw params for %s: %s\n", path, strerror(-err));
+        close(fd);
+        return err;
+    }
+
+    struct pcm_direct *pd = calloc(1, sizeof(*pd));
+    if (!pd) {
+        close(fd);
+        return -ENOMEM;
+    }
+    pd->fd             = fd;
+    pd->io.ops         = &direct_ops;
+    pd->io.stream      = stream;
+    pd->io.rate        = cfg->rate;
+    pd->io.format      = cfg->format;
+    pd->io.channels    = cfg->channels;
+    pd->io.period_size = period;
+    pd->io.buffer_size = buffer;
+    snprintf(pd->io.name, sizeof(pd->io.name), "hw:%d,%d", card, device);
+
+    if ((err = direct_sw_params(pd, cfg->start_threshold)) < 0) {
+        fprintf(stderr, "Cannot set sw params for %s: %s\n", path, strerror(-err));
+        close(fd);
+        free(pd);
+        return err;
+    }
+    direct_map_status(pd);
+
+    *io = &pd->io;
+    return 0;
+}
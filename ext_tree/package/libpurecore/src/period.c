@@ -0,0 +1,69 @@
+/*
+ * Period geometry and pre-buffering — see purecore/period.h
+ */
+
+#include <string.h>
+
+#include "purecore/period.h"
+
+static const struct {
+    const char *name;
+    unsigned long pcm_period;
+    unsigned int prebuf_periods;
+} profiles[PC_LATENCY_COUNT] = {
+    [PC_LATENCY_LOW]    = { "low",     256,  8 },
+    [PC_LATENCY_NORMAL] = { "normal",  512, 16 },
+    [PC_LATENCY_SAFE]   = { "safe",   1024, 16 },
+};
+
+static enum pc_latency clamp(enum pc_latency latency) {
+    return (unsigned int)latency < PC_LATENCY_COUNT ? latency : PC_LATENCY_NORMAL;
+}
+
+const char *pc_latency_name(enum pc_latency latency) {
+    return profiles[clamp(latency)].name;
+}
+
+int pc_latency_parse(const char *name) {
+    for (int i = 0; i < PC_LATENCY_COUNT; i++)
+        if (strcmp(name, profiles[i].name) == 0) return i;
+    return -1;
+}
+
+unsigned long pc_latency_period(enum pc_latency latency) {
+    return profiles[clamp(latency)].pcm_period;
+}
+
+unsigned int pc_latency_prebuffer(enum pc_latency latency) {
+    return profiles[clamp(latency)].prebuf_periods;
+}
+
+void pc_capture_geometry(unsigned int lrck_rate, int is_dsd, struct pc_geometry *g) {
+    /* Buffer gives the gadget feedback loop ~180 ms headroom at any
+     * rate (same as 8192 frames at 44.1k) */
+    g->period     = (!is_dsd && lrck_rate > 192000) ? 1024 : 512;
+    g->buffer     = 65536;
+    g->period_max = 0;
+}
+
+void pc_playback_geometry(enum pc_latency latency, int is_dsd, int i2s,
+                          struct pc_geometry *g) {
+    if (is_dsd) {
+        g->period = PC_DSD_PLAYBACK_PERIOD;
+        g->buffer = PC_DSD_PLAYBACK_BUFFER;
+    } else {
+        g->period = pc_latency_period(latency);
+        g->buffer = g->period * PC_PCM_BUFFER_PERIODS;
+    }
+    /* RV1106 DMA ignores sub-period writes: never let DSD grow */
+    g->period_max = is_dsd && i2s;
+}
+
+unsigned long pc_prebuffer_frames(unsigned int periods, unsigned long period,
+                                  unsigned long max_frames) {
+    unsigned long max = period ? max_frames / period : 0;
+
+    if (periods > max) periods = max;
+    if (periods == 0) periods = 1;
+    return periods * period;
+}
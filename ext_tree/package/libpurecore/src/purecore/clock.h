@@ -0,0 +1,31 @@
+/*
+ * Clock families
+ *
+ * The RV1106 I2S MCLK is derived from one of two audio PLL settings:
+ * multiples of 11025 Hz (44.1k family, 22.5792 MHz base) and multiples
+ * of 8000 Hz (48k family, 24.576 MHz base).  Switching family means
+ * reprogramming the PLL; switching rate within a family only changes
+ * the divider; the same LRCK in the same PCM/DSD mode needs no change
+ * at all — players use pc_same_clock() to skip a PCM reopen.
+ */
+
+#ifndef PURECORE_CLOCK_H
+#define PURECORE_CLOCK_H
+
+enum pc_clock_family {
+    PC_FAMILY_NONE = 0,     /* not a standard audio rate */
+    PC_FAMILY_44K1,
+    PC_FAMILY_48K,
+};
+
+/* Family of a rate as in dsd.h (PCM Hz or DSD bit rate) */
+enum pc_clock_family pc_clock_family(unsigned int rate);
+const char *pc_clock_family_name(enum pc_clock_family family);
+
+/* MCLK for a rate at the given MCLK/LRCK multiplier (i2s.conf MCLK=) */
+unsigned long pc_mclk_hz(unsigned int rate, unsigned int multiplier);
+
+/* Both rates run the outputs identically: same LRCK, same PCM/DSD mode */
+int pc_same_clock(unsigned int rate_a, unsigned int rate_b);
+
+#endif /* PURECORE_CLOCK_H */
@@ -0,0 +1,83 @@
+/*
+ * Clock drift estimator — host (USB) clock against the output clock
+ *
+ * Two-state Kalman filter over timestamped fill samples:
+ *
+ *   e   fill error, frames (fill − set point)
+ *   d   clock offset, ppm (host faster than the DAC clock: d > 0)
+ *
+ *   e(t+dt) = e(t) + (d − u)·rate·1e-6·dt        u = correction applied
+ *   d(t+dt) = d(t)                              (random walk, q_drift)
+ *   z       = e + noise                         (r: sampling jitter)
+ *
+ * and a PLL-style control law on the estimate:
+ *
+ *   u = d̂ + ê / (tau · rate · 1e-6)
+ *
+ * i.e. cancel the estimated offset outright and remove the remaining
+ * fill error with time constant tau.  u is continuous (double ppm), the
+ * feedback pitch is 1000000 − u; pc_drift_quantize() noise-shapes it to
+ * the integer ppm the gadget takes, so the average is sub-ppm exact.
+ *
+ * On top, a step detector: a persistent one-sided innovation (a
+ * changed host clock) re-opens the offset covariance and the filter
+ * re-acquires as at start instead of creeping over minutes.
+ *
+ * Step response (bench/drift_bench.c: tau 2 s, 10 Hz samples with 0.5 ms
+ * of sampling noise, integer pitch, HS Q16.16 wire quantization):
+ *
+ *   rate              |e| < 0.25 ms after         offset error  fill rms
+ *                     +100 ppm from 0  → −50 ppm
+ *   44.1k             7 s              11 s       < 1 ppm       0.04 ms
+ *   192k              3 s              13 s       < 2 ppm       0.06 ms
+ *   705.6k (DSD512)   2 s              11 s       < 1.5 ppm     0.04 ms
+ *
+ * The host build runs the bench for the full table; test_purecore.c
+ * checks convergence at 48k and DSD512.
+ */
+
+#ifndef PURECORE_DRIFT_H
+#define PURECORE_DRIFT_H
+
+#include <stdint.h>
+
+#define PC_DRIFT_TAU_S          2.0     /* fill error time constant */
+#define PC_DRIFT_PPM_MAX        1000.0  /* |u| clamp, 0.1 % */
+#define PC_DRIFT_PITCH_NOMINAL  1000000
+
+struct pc_drift {
+    /* Model */
+    double rate;                /* frames/s (LRCK) */
+    double tau;                 /* s */
+    double r;                   /* measurement variance, frames² */
+    double q_fill, q_drift;     /* process noise: frames²/s, ppm²/s */
+
+    /* Estimate */
+    double e, d;                /* frames, ppm */
+    double p[2][2];             /* covariance */
+    uint64_t last_ns;           /* 0: next sample initialises e */
+    double u;                   /* correction in force since last_ns, ppm */
+    double bias;                /* normalised innovation mean */
+    unsigned int reacquired;    /* step detections */
+    double q_acc;               /* pc_drift_quantize() error feedback */
+};
+
+/* New stream at `lrck_rate`; a known offset (ppm, e.g. from a previous
+ * run) speeds up convergence, pass 0 if none */
+void pc_drift_init(struct pc_drift *s, unsigned int lrck_rate, double offset_ppm);
+
+/* Set point moved (sinks restarted): keep the offset estimate, re-learn
+ * the fill from the next sample */
+void pc_drift_reset_fill(struct pc_drift *s);
+
+/*
+ * One sample: `t_ns` CLOCK_MONOTONIC time the fill was measured, `err`
+ * fill − set point in frames.  Returns the new correction u in ppm
+ * (clamped to ±PC_DRIFT_PPM_MAX); the pitch is 1000000 − u.
+ */
+double pc_drift_update(struct pc_drift *s, uint64_t t_ns, double err);
+
+/* Integer pitch for the gadget with first-order error feedback */
+unsigned int pc_drift_quantize(struct pc_drift *s, double pitch);
+
+#endif /* PURECORE_DRIFT_H */
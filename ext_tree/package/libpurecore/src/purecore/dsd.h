@@ -0,0 +1,34 @@
+/*
+ * DSD rates and naming
+ *
+ * Rates are given the way the UAC2 gadget reports them in sysfs: PCM
+ * sample rate in Hz, or the DSD bit rate for native DSD.  DSD travels
+ * as 32-bit words per channel, so a DSD stream runs the I2S LRCK at
+ * bit rate / 32 (DSD64 = 2822400 → 88200 frames/s).
+ */
+
+#ifndef PURECORE_DSD_H
+#define PURECORE_DSD_H
+
+#define PC_DSD64_RATE       2822400
+#define PC_DSD128_RATE      5644800
+#define PC_DSD256_RATE     11289600
+#define PC_DSD512_RATE     22579200
+#define PC_DSD64_RATE_48    3072000
+#define PC_DSD128_RATE_48   6144000
+#define PC_DSD256_RATE_48  12288000
+#define PC_DSD512_RATE_48  24576000
+
+#define PC_DSD_BITS_PER_FRAME   32      /* per channel, DSD_U32 */
+
+int pc_is_dsd_rate(unsigned int rate);
+
+/* "DSD64/44.1" … "DSD512/48", "Unknown" for anything else */
+const char *pc_dsd_name(unsigned int rate);
+
+/* Frames per second on the wire: rate / 32 for DSD, rate for PCM */
+static inline unsigned int pc_lrck_rate(unsigned int rate) {
+    return pc_is_dsd_rate(rate) ? rate / PC_DSD_BITS_PER_FRAME : rate;
+}
+
+#endif /* PURECORE_DSD_H */
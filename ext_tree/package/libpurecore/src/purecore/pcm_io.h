@@ -0,0 +1,94 @@
+/*
+ * PCM I/O backends for the router.
+ *
+ *   alsa   — snd_pcm_open("hw:C,D") through alsa-lib (default)
+ *   direct — ioctl() on /dev/snd/pcmCxDy[pc], no alsa-lib config
+ *            parsing or plugin layer, one syscall per transfer
+ *
+ * Both backends expose the same RW-interleaved subset the router
+ * needs, blocking unless pcm_config.nonblock is set (transfers then
+ * return -EAGAIN instead of waiting).  This header is alsa-lib free on purpose: the direct
+ * backend includes the kernel uapi <sound/asound.h>, whose types clash
+ * with alsa-lib's.  Formats are kernel SNDRV_PCM_FORMAT_* numbers
+ * (identical to alsa-lib's SND_PCM_FORMAT_*), streams are 0=playback,
+ * 1=capture like SND_PCM_STREAM_*.  Errors are negative errno values
+ * (reported on stderr); success is silent so open can be benchmarked.
+ */
+
+#ifndef PCM_IO_H
+#define PCM_IO_H
+
+enum pcm_backend {
+    PCM_BACKEND_ALSA = 0,
+    PCM_BACKEND_DIRECT,
+};
+
+#define PCM_IO_PLAYBACK 0
+#define PCM_IO_CAPTURE  1
+
+struct pcm_config {
+    unsigned int rate;
+    int format;
+    unsigned int channels;
+    unsigned long period_size;  /* requested, nearest is taken */
+    unsigned long buffer_size;  /* requested, nearest is taken */
+    int period_max;             /* period_size is an upper bound (RV1106 DSD playback) */
+    unsigned long start_threshold;
+    int nonblock;               /* O_NONBLOCK / SND_PCM_NONBLOCK */
+};
+
+struct pcm_io;
+
+struct pcm_io_ops {
+    long (*readi)(struct pcm_io *io, void *buf, unsigned long frames);
+    long (*writei)(struct pcm_io *io, const void *buf, unsigned long frames);
+    int  (*prepare)(struct pcm_io *io);
+    int  (*start)(struct pcm_io *io);
+    int  (*drop)(struct pcm_io *io);
+    int  (*avail_delay)(struct pcm_io *io, long *avail, long *delay);
+    int  (*wait)(struct pcm_io *io, int timeout_ms);   /* 1 ready, 0 timeout */
+    void (*close)(struct pcm_io *io);
+};
+
+struct pcm_io {
+    const struct pcm_io_ops *ops;
+    int stream;
+    unsigned int rate;
+    int format;
+    unsigned int channels;
+    unsigned long period_size;  /* negotiated */
+    unsigned long buffer_size;  /* negotiated */
+    char name[32];
+};
+
+int pcm_alsa_open(struct pcm_io **io, int card, int device, int stream,
+                  const struct pcm_config *cfg);
+int pcm_direct_open(struct pcm_io **io, int card, int device, int stream,
+                    const struct pcm_config *cfg);
+
+static inline int pcm_io_open(struct pcm_io **io, enum pcm_backend backend,
+                              int card, int device, int stream,
+                              const struct pcm_config *cfg) {
+    return backend == PCM_BACKEND_DIRECT
+        ? pcm_direct_open(io, card, device, stream, cfg)
+        : pcm_alsa_open(io, card, device, stream, cfg);
+}
+
+static inline long pcm_io_readi(struct pcm_io *io, void *buf, unsigned long frames) {
+    return io->ops->readi(io, buf, frames);
+}
+static inline long pcm_io_writei(struct pcm_io *io, const void *buf, unsigned long frames) {
+    return io->ops->writei(io, buf, frames);
+}
+static inline int pcm_io_prepare(struct pcm_io *io) { return io->ops->prepare(io); }
+static inline int pcm_io_start(struct pcm_io *io)   { return io->ops->start(io); }
+static inline int pcm_io_drop(struct pcm_io *io)    { return io->ops->drop(io); }
+static inline int pcm_io_avail_delay(struct pcm_io *io, long *avail, long *delay) {
+    return io->ops->avail_delay(io, avail, delay);
+}
+static inline int pcm_io_wait(struct pcm_io *io, int timeout_ms) {
+    return io->ops->wait(io, timeout_ms);
+}
+static inline void pcm_io_close(struct pcm_io *io)  { io->ops->close(io); }
+
+#endif /* PCM_IO_H */
@@ -0,0 +1,60 @@
+/*
+ * Period geometry and pre-buffering on the RV1106
+ *
+ * Constraints the I2S DMA imposes, learned the hard way:
+ *   - it only picks up data at period boundaries, sub-period writes are
+ *     invisible until the period completes
+ *   - start_threshold is ignored, DMA starts on the first writei(), so a
+ *     pre-buffer must be written in one burst (pc_prebuffer_frames())
+ *   - DSD playback must stay at 512-frame periods (period_max in
+ *     pcm_io.h); larger ones starve DSD512
+ *
+ * Latency profiles choose the PCM playback period and the default
+ * pre-buffer depth; capture geometry is fixed, the gadget feedback loop
+ * is tuned around it.
+ */
+
+#ifndef PURECORE_PERIOD_H
+#define PURECORE_PERIOD_H
+
+enum pc_latency {
+    PC_LATENCY_LOW = 0,
+    PC_LATENCY_NORMAL,
+    PC_LATENCY_SAFE,
+    PC_LATENCY_COUNT,
+};
+
+#define PC_DSD_PLAYBACK_PERIOD  512
+#define PC_DSD_PLAYBACK_BUFFER  32768
+#define PC_PCM_BUFFER_PERIODS   16
+#define PC_MAX_PREBUFFER        64      /* periods */
+
+struct pc_geometry {
+    unsigned long period;       /* frames */
+    unsigned long buffer;       /* frames */
+    int period_max;             /* period is an upper bound (pcm_config) */
+};
+
+const char *pc_latency_name(enum pc_latency latency);
+int pc_latency_parse(const char *name);             /* -1 if unknown */
+
+/* PCM playback period and default pre-buffer periods of a profile */
+unsigned long pc_latency_period(enum pc_latency latency);
+unsigned int pc_latency_prebuffer(enum pc_latency latency);
+
+/* UAC2 gadget capture at LRCK rate `lrck_rate` */
+void pc_capture_geometry(unsigned int lrck_rate, int is_dsd, struct pc_geometry *g);
+
+/* Playback on the RV1106 I2S (i2s != 0) or any other card */
+void pc_playback_geometry(enum pc_latency latency, int is_dsd, int i2s,
+                          struct pc_geometry *g);
+
+/*
+ * Frames to pre-buffer before the first write: `periods` (0 = profile
+ * default via pc_latency_prebuffer()) whole periods, clamped to what
+ * fits in `max_frames` and to at least one period.
+ */
+unsigned long pc_prebuffer_frames(unsigned int periods, unsigned long period,
+                                  unsigned long max_frames);
+
+#endif /* PURECORE_PERIOD_H */
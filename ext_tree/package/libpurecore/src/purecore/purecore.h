@@ -0,0 +1,33 @@
+/*
+ * libpurecore — audio engine pieces shared by uac2_router and the
+ * on-device players of PureFox / PureCore
+ *
+ *   dsd.h      DSD rate table, names, LRCK
+ *   clock.h    44.1k / 48k clock families, MCLK
+ *   period.h   RV1106 period constraints, latency profiles, pre-buffer
+ *   swap.h     DSD byte swap, S24 packing, DoP (NEON)
+ *   pcm_io.h   alsa-lib and direct-ioctl PCM backends
+ *   drift.h    host/DAC clock offset estimator for USB feedback (1.1)
+ *
+ * The API is C, stable within a major version (soname libpurecore.so.N):
+ * existing functions and struct layouts don't change, new ones are
+ * appended and PURECORE_VERSION_MINOR is bumped.
+ */
+
+#ifndef PURECORE_H
+#define PURECORE_H
+
+#define PURECORE_VERSION_MAJOR  1
+#define PURECORE_VERSION_MINOR  1
+
+#include "dsd.h"
+#include "clock.h"
+#include "period.h"
+#include "swap.h"
+#include "pcm_io.h"
+#include "drift.h"
+
+/* Library version the program runs against, MAJOR << 16 | MINOR */
+unsigned int purecore_version(void);
+
+#endif /* PURECORE_H */
@@ -0,0 +1,40 @@
+/*
+ * Sample kernels — NEON on ARMv7, plain C elsewhere
+ *
+ * All operate on interleaved stereo, 32 bits per sample:
+ *   DSD   USB RAW_DATA sends DSD bytes oldest-first [B0 B1 B2 B3];
+ *         ALSA DSD_U32_LE stores the oldest byte in the MSB.  Without
+ *         the swap, I2S plays violet noise.
+ *   S24   S32_LE to packed S24_3LE (top 24 bits), for DACs without
+ *         32-bit support
+ *   DoP   DSD over PCM: each DSD_U32 word becomes two PCM frames of
+ *         16 DSD bits under an alternating 0x05/0xFA marker, at twice
+ *         the LRCK
+ */
+
+#ifndef PURECORE_SWAP_H
+#define PURECORE_SWAP_H
+
+#include <stdint.h>
+
+#define PC_BSWAP32(x) (((x) >> 24) | (((x) >> 8) & 0xFF00) | \
+                       (((x) << 8) & 0xFF0000) | ((x) << 24))
+
+#define PC_DOP_MARKER_A     0x05
+#define PC_DOP_MARKER_B     0xFA
+
+/* USB byte order ↔ DSD_U32_LE, `words` 32-bit words; dst may equal src */
+void pc_dsd_swap(uint32_t *dst, const uint32_t *src, unsigned long words);
+
+/* S32_LE → S24_3LE, `words` samples, 3 bytes out per sample */
+void pc_pack_s24_3le(uint8_t *dst, const uint32_t *src, unsigned long words);
+
+/*
+ * DSD_U32_LE (oldest byte in the MSB) → DoP, `frames` stereo input
+ * frames, 2 × frames output frames as S32_LE (s24 = 0) or S24_3LE.
+ * *phase carries the marker alternation across calls.
+ */
+void pc_dop_encode(uint8_t *dst, const uint32_t *src, unsigned long frames,
+                   int s24, unsigned int *phase);
+
+#endif /* PURECORE_SWAP_H */
@@ -0,0 +1,79 @@
+/*
+ * Sample kernels — see purecore/swap.h
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PURECORE_NEON 1
+#endif
+
+#include "purecore/swap.h"
+
+void pc_dsd_swap(uint32_t *dst, const uint32_t *src, unsigned long words) {
+    unsigned long i = 0;
+
+#ifdef PURECORE_NEON
+    for (; i + 8 <= words; i += 8) {
+        uint8x16_t a = vld1q_u8((const uint8_t *)(src + i));
+        uint8x16_t b = vld1q_u8((const uint8_t *)(src + i + 4));
+        vst1q_u8((uint8_t *)(dst + i), vrev32q_u8(a));
+        vst1q_u8((uint8_t *)(dst + i + 4), vrev32q_u8(b));
+    }
+#endif
+
+    for (; i < words; i++)
+        dst[i] = PC_BSWAP32(src[i]);
+}
+
+static inline void put_s24_3le(uint8_t *d, uint32_t v) {
+    d[0] = v >> 8;
+    d[1] = v >> 16;
+    d[2] = v >> 24;
+}
+
+void pc_pack_s24_3le(uint8_t *dst, const uint32_t *src, unsigned long words) {
+    unsigned long i = 0;
+
+#ifdef PURECORE_NEON
+    /* Top three bytes of each little-endian word, 4 words → 12 bytes */
+    static const uint8_t lo_idx[8] = { 1, 2, 3, 5, 6, 7, 9, 10 };
+    static const uint8_t hi_idx[8] = { 11, 13, 14, 15, 0, 0, 0, 0 };
+    const uint8x8_t lo = vld1_u8(lo_idx), hi = vld1_u8(hi_idx);
+
+    for (; i + 4 <= words; i += 4, dst += 12) {
+        uint8x16_t v = vld1q_u8((const uint8_t *)(src + i));
+        uint8x8x2_t t = { { vget_low_u8(v), vget_high_u8(v) } };
+        vst1_u8(dst, vtbl2_u8(t, lo));
+        uint32_t tail = vget_lane_u32(vreinterpret_u32_u8(vtbl2_u8(t, hi)), 0);
+        memcpy(dst + 8, &tail, 4);      /* dst is only byte aligned */
+    }
+#endif
+
+    for (; i < words; i++, dst += 3)
+        put_s24_3le(dst, src[i]);
+}
+
+void pc_dop_encode(uint8_t *dst, const uint32_t *src, unsigned long frames,
+                   int s24, unsigned int *phase) {
+    unsigned int ph = *phase;
+
+    /* Upper 16 DSD bits (older) go out first, same marker on L and R */
+    for (unsigned long f = 0; f < frames; f++, src += 2) {
+        for (int shift = 16; shift >= 0; shift -= 16) {
+            uint32_t m = (ph++ & 1) ? PC_DOP_MARKER_B : PC_DOP_MARKER_A;
+            for (int ch = 0; ch < 2; ch++) {
+                uint32_t v = (m << 24) | (((src[ch] >> shift) & 0xFFFF) << 8);
+                if (s24) {
+                    put_s24_3le(dst, v);
+                    dst += 3;
+                } else {
+                    memcpy(dst, &v, 4);
+                    dst += 4;
+                }
+            }
+        }
+    }
+    *phase = ph;
+}
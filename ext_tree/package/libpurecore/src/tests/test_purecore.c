@@ -0,0 +1,262 @@
+/*
+ * libpurecore host unit tests
+ *
+ * Built and run by "make host-libpurecore"; also plain
+ *   cc -I.. -o test_purecore test_purecore.c ../dsd.c ../clock.c \
+ *      ../period.c ../swap.c ../drift.c ../version.c -lm && ./test_purecore
+ * Exit status is the number of failed checks.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "purecore/dsd.h"
+#include "purecore/clock.h"
+#include "purecore/period.h"
+#include "purecore/swap.h"
+#include "purecore/drift.h"
+#include "purecore/purecore.h"
+
+static int failures, checks;
+
+#define CHECK(cond) do {                                                \
+    checks++;                                                           \
+    if (!(cond)) {                                                      \
+        failures++;                                                     \
+        fprintf(stderr, "FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+    }                                                                   \
+} while (0)
+
+/* ── Rates ── */
+
+static void test_dsd(void) {
+    CHECK(pc_is_dsd_rate(PC_DSD64_RATE));
+    CHECK(pc_is_dsd_rate(PC_DSD512_RATE_48));
+    CHECK(!pc_is_dsd_rate(44100));
+    CHECK(!pc_is_dsd_rate(384000));
+    CHECK(!pc_is_dsd_rate(0));
+
+    CHECK(strcmp(pc_dsd_name(PC_DSD128_RATE), "DSD128/44.1") == 0);
+    CHECK(strcmp(pc_dsd_name(PC_DSD256_RATE_48), "DSD256/48") == 0);
+    CHECK(strcmp(pc_dsd_name(96000), "Unknown") == 0);
+
+    CHECK(pc_lrck_rate(PC_DSD64_RATE) == 88200);
+    CHECK(pc_lrck_rate(PC_DSD512_RATE_48) == 768000);
+    CHECK(pc_lrck_rate(192000) == 192000);
+}
+
+static void test_clock(void) {
+    CHECK(pc_clock_family(44100) == PC_FAMILY_44K1);
+    CHECK(pc_clock_family(352800) == PC_FAMILY_44K1);
+    CHECK(pc_clock_family(PC_DSD256_RATE) == PC_FAMILY_44K1);
+    CHECK(pc_clock_family(48000) == PC_FAMILY_48K);
+    CHECK(pc_clock_family(768000) == PC_FAMILY_48K);
+    CHECK(pc_clock_family(PC_DSD64_RATE_48) == PC_FAMILY_48K);
+    CHECK(pc_clock_family(0) == PC_FAMILY_NONE);
+    CHECK(pc_clock_family(12345) == PC_FAMILY_NONE);
+
+    CHECK(pc_mclk_hz(44100, 512) == 22579200);
+    CHECK(pc_mclk_hz(PC_DSD64_RATE, 256) == 22579200);
+
+    CHECK(pc_same_clock(96000, 96000));
+    CHECK(!pc_same_clock(96000, 48000));
+    /* DSD64 and 88.2k share LRCK but not the output mode */
+    CHECK(!pc_same_clock(PC_DSD64_RATE, 88200));
+    CHECK(pc_same_clock(PC_DSD128_RATE, PC_DSD128_RATE));
+}
+
+/* ── Geometry ── */
+
+static void test_period(void) {
+    struct pc_geometry g;
+
+    CHECK(strcmp(pc_latency_name(PC_LATENCY_LOW), "low") == 0);
+    CHECK(strcmp(pc_latency_name((enum pc_latency)42), "normal") == 0);
+    CHECK(pc_latency_parse("safe") == PC_LATENCY_SAFE);
+    CHECK(pc_latency_parse("fast") == -1);
+    CHECK(pc_latency_period(PC_LATENCY_LOW) == 256);
+    CHECK(pc_latency_prebuffer(PC_LATENCY_NORMAL) == 16);
+
+    pc_capture_geometry(44100, 0, &g);
+    CHECK(g.period == 512 && g.buffer == 65536 && !g.period_max);
+    pc_capture_geometry(384000, 0, &g);
+    CHECK(g.period == 1024);
+    pc_capture_geometry(pc_lrck_rate(PC_DSD512_RATE), 1, &g);
+    CHECK(g.period == 512);
+
+    pc_playback_geometry(PC_LATENCY_SAFE, 0, 1, &g);
+    CHECK(g.period == 1024 && g.buffer == 1024 * PC_PCM_BUFFER_PERIODS && !g.period_max);
+    pc_playback_geometry(PC_LATENCY_LOW, 1, 1, &g);
+    CHECK(g.period == PC_DSD_PLAYBACK_PERIOD && g.buffer == PC_DSD_PLAYBACK_BUFFER);
+    CHECK(g.period_max);
+    pc_playback_geometry(PC_LATENCY_LOW, 1, 0, &g);
+    CHECK(!g.period_max);
+
+    CHECK(pc_prebuffer_frames(4, 512, 8192) == 2048);
+    CHECK(pc_prebuffer_frames(64, 512, 8192) == 8192);     /* clamped to buffer */
+    CHECK(pc_prebuffer_frames(0, 512, 8192) == 512);       /* at least one period */
+}
+
+/* ── Kernels, against the obvious scalar code ── */
+
+static uint32_t rnd_state = 0x12345678;
+
+static uint32_t rnd(void) {
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 17;
+    rnd_state ^= rnd_state << 5;
+    return rnd_state;
+}
+
+static void test_swap(void) {
+    static uint32_t src[1031], dst[1031];
+
+    for (unsigned i = 0; i < 1031; i++) src[i] = rnd();
+    CHECK(PC_BSWAP32(0x11223344u) == 0x44332211u);
+
+    /* Odd lengths exercise the vector loop and the scalar tail */
+    for (unsigned long n = 0; n <= 1031; n += 103) {
+        memset(dst, 0, sizeof(dst));
+        pc_dsd_swap(dst, src, n);
+        int ok = 1;
+        for (unsigned long i = 0; i < n; i++)
+            if (dst[i] != __builtin_bswap32(src[i])) ok = 0;
+        for (unsigned long i = n; i < 1031; i++)
+            if (dst[i] != 0) ok = 0;
+        CHECK(ok);
+    }
+
+    /* In place */
+    memcpy(dst, src, sizeof(src));
+    pc_dsd_swap(dst, dst, 1031);
+    pc_dsd_swap(dst, dst, 1031);
+    CHECK(memcmp(dst, src, sizeof(src)) == 0);
+}
+
+static void test_pack(void) {
+    static uint32_t src[1027];
+    static uint8_t dst[1027 * 3 + 1];
+
+    for (unsigned i = 0; i < 1027; i++) src[i] = rnd();
+
+    for (unsigned long n = 1; n <= 1027; n += 37) {
+        memset(dst, 0xAA, sizeof(dst));
+        pc_pack_s24_3le(dst, src, n);
+        int ok = 1;
+        for (unsigned long i = 0; i < n; i++)
+            if (dst[3 * i]     != (uint8_t)(src[i] >> 8)  ||
+                dst[3 * i + 1] != (uint8_t)(src[i] >> 16) ||
+                dst[3 * i + 2] != (uint8_t)(src[i] >> 24)) ok = 0;
+        if (dst[3 * n] != 0xAA) ok = 0;         /* no overrun */
+        CHECK(ok);
+    }
+}
+
+static void test_dop(void) {
+    /* One frame: L = 0xAABBCCDD, R = 0x11223344 → two DoP frames */
+    const uint32_t src[4] = { 0xAABBCCDDu, 0x11223344u, 0x01020304u, 0x05060708u };
+    uint32_t out[8];
+    uint8_t out24[8 * 3];
+    unsigned int phase = 0;
+
+    pc_dop_encode((uint8_t *)out, src, 2, 0, &phase);
+    CHECK(phase == 4);
+    CHECK(out[0] == (0x05u << 24 | 0xAABBu << 8));
+    CHECK(out[1] == (0x05u << 24 | 0x1122u << 8));
+    CHECK(out[2] == (0xFAu << 24 | 0xCCDDu << 8));
+    CHECK(out[3] == (0xFAu << 24 | 0x3344u << 8));
+    CHECK(out[4] == (0x05u << 24 | 0x0102u << 8));
+    CHECK(out[7] == (0xFAu << 24 | 0x0708u << 8));
+
+    /* Marker keeps alternating across calls */
+    phase = 1;
+    pc_dop_encode((uint8_t *)out, src, 1, 0, &phase);
+    CHECK(out[0] >> 24 == PC_DOP_MARKER_B && out[2] >> 24 == PC_DOP_MARKER_A);
+    CHECK(phase == 3);
+
+    /* S24_3LE carries the same upper three bytes */
+    phase = 0;
+    pc_dop_encode((uint8_t *)out, src, 2, 0, &phase);
+    phase = 0;
+    pc_dop_encode(out24, src, 2, 1, &phase);
+    int ok = 1;
+    for (int i = 0; i < 8; i++)
+        if (out24[3 * i] != (uint8_t)(out[i] >> 8) ||
+            out24[3 * i + 1] != (uint8_t)(out[i] >> 16) ||
+            out24[3 * i + 2] != (uint8_t)(out[i] >> 24)) ok = 0;
+    CHECK(ok);
+}
+
+/* ── Drift estimator, noiseless closed loop (bench/ does the noisy one) ── */
+
+struct loop {
+    struct pc_drift s;
+    double fill, offset;        /* frames, true ppm */
+    uint64_t t_ns;
+};
+
+static void loop_run(struct loop *l, double seconds) {
+    for (int i = 0; i < (int)(seconds * 10); i++) {
+        l->t_ns += 100000000;
+        double u = pc_drift_update(&l->s, l->t_ns, l->fill);
+        unsigned int pitch = pc_drift_quantize(&l->s, PC_DRIFT_PITCH_NOMINAL - u);
+        l->fill += (l->offset - (PC_DRIFT_PITCH_NOMINAL - (double)pitch))
+                   * l->s.rate * 1e-6 * 0.1;
+    }
+}
+
+static void test_drift(void) {
+    static const unsigned int rates[] = { 48000, 705600 };
+
+    for (unsigned int i = 0; i < 2; i++) {
+        struct loop l = { .offset = 100.0, .t_ns = 1 };
+
+        pc_drift_init(&l.s, rates[i], 0.0);
+        loop_run(&l, 20.0);
+        CHECK(fabs(l.s.d - 100.0) < 1.0);
+        CHECK(fabs(l.fill) < rates[i] / 4000.0);   /* 0.25 ms */
+
+        l.offset = -50.0;
+        loop_run(&l, 30.0);
+        CHECK(fabs(l.s.d + 50.0) < 1.0);
+        CHECK(fabs(l.fill) < rates[i] / 4000.0);
+        CHECK(l.s.reacquired > 0);
+
+        /* Set point moved: the offset estimate survives */
+        pc_drift_reset_fill(&l.s);
+        l.fill = 0.0;
+        loop_run(&l, 0.2);
+        CHECK(fabs(l.s.d + 50.0) < 1.0);
+    }
+
+    /* Clamp, and integer pitch averages to the continuous one */
+    struct pc_drift s;
+    pc_drift_init(&s, 48000, 0.0);
+    CHECK(pc_drift_update(&s, 1, 1e9) == PC_DRIFT_PPM_MAX);
+
+    pc_drift_init(&s, 48000, 0.0);
+    double sum = 0.0;
+    for (int i = 0; i < 1000; i++) sum += pc_drift_quantize(&s, 1000012.3);
+    CHECK(fabs(sum / 1000 - 1000012.3) < 0.01);
+
+    /* A seeded offset is taken as is */
+    pc_drift_init(&s, 96000, -12.5);
+    CHECK(s.d == -12.5);
+}
+
+int main(void) {
+    test_dsd();
+    test_clock();
+    test_period();
+    test_swap();
+    test_pack();
+    test_dop();
+    test_drift();
+    CHECK(purecore_version() == (PURECORE_VERSION_MAJOR << 16 | PURECORE_VERSION_MINOR));
+
+    printf("%s: %d/%d checks passed\n", failures ? "FAIL" : "PASS",
+           checks - failures, checks);
+    return failures;
+}
@@ -0,0 +1,9 @@
+/*
+ * Library version — see purecore/purecore.h
+ */
+
+#include "purecore/purecore.h"
+
+unsigned int purecore_version(void) {
+    return PURECORE_VERSION_MAJOR << 16 | PURECORE_VERSION_MINOR;
+}
@@ -0,0 +1,207 @@
+/*
+ * Shared-memory audio bus, producer side — see audio_bus.h
+ *
+ * Cost on the audio thread per period: one memcpy of the period into
+ * the ring (skipped while nobody is attached), two atomic stores, and
+ * one eventfd write per attached consumer (non-blocking; a consumer
+ * that never reads only lets the counter grow).  Eventfds are created once per slot and never closed
+ * while running, so the audio thread can't race a reused fd number.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+#include "audio_bus.h"
+
+#define BUS_MAX_FRAMES  (1UL << 20)     /* 8 MiB */
+
+static struct audio_bus_header *hdr;
+static uint8_t *ring;
+static size_t map_size;
+static int bus_fd = -1;
+static int slot_efd[AUDIO_BUS_MAX_CONSUMERS];
+
+int audio_bus_init(unsigned long ring_frames) {
+    unsigned long frames = 1024;
+
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS; i++)
+        slot_efd[i] = -1;
+    if (ring_frames == 0)
+        return 0;
+
+    while (frames < ring_frames && frames < BUS_MAX_FRAMES)
+        frames <<= 1;
+    map_size = AUDIO_BUS_HEADER_SIZE + frames * AUDIO_BUS_FRAME_BYTES;
+
+    bus_fd = memfd_create("uac2_router.bus", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (bus_fd < 0) {
+        fprintf(stderr, "[BUS] memfd_create: %s\n", strerror(errno));
+        return -1;
+    }
+    if (ftruncate(bus_fd, map_size) < 0) {
+        fprintf(stderr, "[BUS] Cannot size bus: %s\n", strerror(errno));
+        goto fail;
+    }
+    /* Consumers map it too — forbid resizing under their feet */
+    fcntl(bus_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    hdr = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, bus_fd, 0);
+    if (hdr == MAP_FAILED) {
+        hdr = NULL;
+        fprintf(stderr, "[BUS] mmap: %s\n", strerror(errno));
+        goto fail;
+    }
+    ring = (uint8_t *)hdr + AUDIO_BUS_HEADER_SIZE;
+
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS; i++) {
+        slot_efd[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (slot_efd[i] < 0) {
+            fprintf(stderr, "[BUS] eventfd: %s\n", strerror(errno));
+            goto fail;
+        }
+    }
+
+    hdr->magic       = AUDIO_BUS_MAGIC;
+    hdr->version     = AUDIO_BUS_VERSION;
+    hdr->header_size = AUDIO_BUS_HEADER_SIZE;
+    hdr->frame_bytes = AUDIO_BUS_FRAME_BYTES;
+    hdr->ring_frames = frames;
+
+    printf("[BUS] %lu frames (%zu KiB)\n", frames, map_size / 1024);
+    return 0;
+
+fail:
+    audio_bus_exit();
+    return -1;
+}
+
+void audio_bus_exit(void) {
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS; i++) {
+        if (slot_efd[i] >= 0) close(slot_efd[i]);
+        slot_efd[i] = -1;
+    }
+    if (hdr) munmap(hdr, map_size);
+    hdr = NULL;
+    if (bus_fd >= 0) close(bus_fd);
+    bus_fd = -1;
+}
+
+void audio_bus_set_format(unsigned int rate, unsigned int lrck_rate, int is_dsd) {
+    if (!hdr) return;
+
+    uint32_t s = atomic_load_explicit(&hdr->fmt_seq, memory_order_relaxed);
+    atomic_store_explicit(&hdr->fmt_seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    hdr->fmt_rate      = rate;
+    hdr->fmt_lrck_rate = lrck_rate;
+    hdr->fmt_is_dsd    = is_dsd;
+    hdr->fmt_start_pos = atomic_load_explicit(&hdr->write_pos, memory_order_relaxed);
+    atomic_store_explicit(&hdr->fmt_seq, s + 2, memory_order_release);
+}
+
+void audio_bus_write(const void *frames, unsigned long n) {
+    static const uint64_t one = 1;
+
+    if (!hdr) return;
+
+    const uint64_t size = hdr->ring_frames;
+    if (n > size) {                     /* never happens with sane periods */
+        frames = (const uint8_t *)frames + (n - size) * AUDIO_BUS_FRAME_BYTES;
+        n = size;
+    }
+
+    uint64_t w = atomic_load_explicit(&hdr->write_pos, memory_order_relaxed);
+    uint64_t off = w & (size - 1);
+    uint64_t first = (off + n > size) ? size - off : n;
+
+    /* Claim before touching the ring so readers can detect being lapped.
+     * Nobody attached: only the positions move (attach pairs with this,
+     * see audio_bus_attach()). */
+    atomic_store(&hdr->write_claim, w + n);
+    uint32_t mask = atomic_load(&hdr->active_mask);
+    if (mask) {
+        memcpy(ring + off * AUDIO_BUS_FRAME_BYTES, frames, first * AUDIO_BUS_FRAME_BYTES);
+        if (n > first)
+            memcpy(ring, (const uint8_t *)frames + first * AUDIO_BUS_FRAME_BYTES,
+                   (n - first) * AUDIO_BUS_FRAME_BYTES);
+    }
+    atomic_store_explicit(&hdr->write_pos, w + n, memory_order_release);
+
+    while (mask) {
+        int i = __builtin_ctz(mask);
+        mask &= mask - 1;
+        if (write(slot_efd[i], &one, sizeof(one)) < 0) { /* EAGAIN: counter full */ }
+    }
+}
+
+/* ── Control thread ───────────────────────────────────────────────── */
+
+static int pid_alive(int pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+int audio_bus_attach(int pid, int *memfd, int *efd) {
+    uint64_t drain;
+
+    if (!hdr) return -1;
+
+    /* Reclaim slots of consumers that exited without detaching */
+    uint32_t mask = atomic_load(&hdr->active_mask);
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS; i++)
+        if ((mask & (1u << i)) && !pid_alive(hdr->consumers[i].pid))
+            atomic_fetch_and(&hdr->active_mask, ~(1u << i));
+
+    mask = atomic_load(&hdr->active_mask);
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS; i++) {
+        if (mask & (1u << i)) continue;
+
+        struct audio_bus_consumer *c = &hdr->consumers[i];
+        c->pid     = pid;
+        c->fmt_seq = atomic_load(&hdr->fmt_seq) & ~1u;
+        atomic_store(&c->overruns, 0);
+        atomic_store(&c->read_pos, atomic_load(&hdr->write_pos));
+        while (read(slot_efd[i], &drain, sizeof(drain)) > 0)
+            ;
+        /* Bit first, then the claim: a period the producer skipped
+         * (mask still empty) lies before the claim we read.  Start there
+         * once it is written; the consumer has no fds yet. */
+        atomic_fetch_or(&hdr->active_mask, 1u << i);
+        uint64_t start = atomic_load(&hdr->write_claim);
+        while (atomic_load(&hdr->write_pos) < start)
+            sched_yield();
+        atomic_store(&c->read_pos, start);
+
+        *memfd = bus_fd;
+        *efd   = slot_efd[i];
+        return i;
+    }
+    return -1;
+}
+
+int audio_bus_stats(char *out, size_t size) {
+    int len = 0;
+
+    if (!hdr || size == 0) return 0;
+
+    uint64_t w = atomic_load(&hdr->write_pos);
+    uint32_t mask = atomic_load(&hdr->active_mask);
+    len += snprintf(out + len, size - len, "bus_frames=%llu\nbus_written=%llu\n",
+                    (unsigned long long)hdr->ring_frames, (unsigned long long)w);
+    for (int i = 0; i < AUDIO_BUS_MAX_CONSUMERS && len < (int)size; i++) {
+        if (!(mask & (1u << i))) continue;
+        struct audio_bus_consumer *c = &hdr->consumers[i];
+        len += snprintf(out + len, size - len, "bus%d=pid:%d lag:%llu overruns:%llu\n",
+                        i, c->pid, (unsigned long long)(w - atomic_load(&c->read_pos)),
+                        (unsigned long long)atomic_load(&c->overruns));
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
@@ -0,0 +1,146 @@
+/*
+ * Shared-memory audio bus — post-swap USB stream for extra consumers
+ *
+ * One memfd holds a header page followed by a ring of I2S-ready frames
+ * (2 ch × 32 bit, DSD already byte-swapped).  The router is the only
+ * producer: every captured period is copied into the ring once and
+ * write_pos is advanced, no matter how many consumers are attached
+ * (with none, only write_pos moves).
+ * Consumers (level meter, network sender, recorder …) keep their own
+ * read cursor in the header; nothing they do can stall the producer.
+ *
+ * Attaching: send "bus" on the control socket (ctl_socket.h).  The
+ * reply "bus slot=<n>" carries two fds via SCM_RIGHTS: the memfd
+ * (sealed against resizing; size = header_size + ring_frames ×
+ * frame_bytes) and the slot's eventfd, which the producer signals
+ * after each period.  Detach by
+ * clearing the slot bit in active_mask; slots of exited processes are
+ * reclaimed on the next attach.
+ *
+ * Reading: audio_bus_read() below.  A consumer that falls more than a
+ * ring behind (or is overtaken while copying) gets AUDIO_BUS_OVERRUN,
+ * its overrun counter is bumped and the cursor jumps to the live edge.
+ * A format change (rate / PCM↔DSD) is signalled the same way with
+ * AUDIO_BUS_FORMAT; fmt_seq/fmt_* then describe the new stream.
+ *
+ * This header is shared with out-of-tree consumers — keep it free of
+ * router internals and bump AUDIO_BUS_VERSION on layout changes.
+ */
+
+#ifndef AUDIO_BUS_H
+#define AUDIO_BUS_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#define AUDIO_BUS_MAGIC         0x53554241u     /* "ABUS" */
+#define AUDIO_BUS_VERSION       1
+#define AUDIO_BUS_HEADER_SIZE   4096            /* data ring starts here */
+#define AUDIO_BUS_MAX_CONSUMERS 8
+#define AUDIO_BUS_FRAME_BYTES   8               /* 2 ch × 32 bit */
+
+#define AUDIO_BUS_OVERRUN       (-1)
+#define AUDIO_BUS_FORMAT        (-2)
+
+struct audio_bus_consumer {
+    _Atomic uint64_t read_pos;      /* frames, written by the consumer */
+    _Atomic uint64_t overruns;      /* written by the consumer */
+    int32_t pid;                    /* set on attach */
+    uint32_t fmt_seq;               /* consumer's last seen fmt_seq */
+    uint8_t pad[40];                /* one cache line per consumer */
+};
+
+struct audio_bus_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t frame_bytes;
+    uint64_t ring_frames;           /* power of two */
+
+    /* Stream format; seqcount, odd while the producer updates it */
+    _Atomic uint32_t fmt_seq;
+    uint32_t fmt_rate;              /* USB rate, DSD bit rate for DSD */
+    uint32_t fmt_lrck_rate;         /* frames per second in the ring */
+    uint32_t fmt_is_dsd;            /* 1: DSD_U32_LE, 0: S32_LE */
+    uint64_t fmt_start_pos;         /* first frame in this format */
+
+    _Atomic uint64_t write_claim;   /* end of the chunk being copied in */
+    _Atomic uint64_t write_pos;     /* frames ever written, producer only */
+    _Atomic uint32_t active_mask;   /* bit n = consumers[n] attached */
+    uint32_t reserved;
+
+    struct audio_bus_consumer consumers[AUDIO_BUS_MAX_CONSUMERS];
+};
+
+/*
+ * Copy up to max_frames new frames for consumer `slot` into dst.
+ * Returns frames copied (0 = nothing new), AUDIO_BUS_OVERRUN or
+ * AUDIO_BUS_FORMAT (cursor already moved; just call again).
+ */
+static inline long audio_bus_read(struct audio_bus_header *hdr, const uint8_t *ring,
+                                  int slot, void *dst, unsigned long max_frames)
+{
+    struct audio_bus_consumer *c = &hdr->consumers[slot];
+    const uint64_t size = hdr->ring_frames;
+    const unsigned int fb = hdr->frame_bytes;
+
+    uint32_t fs = atomic_load_explicit(&hdr->fmt_seq, memory_order_acquire);
+    if (!(fs & 1) && fs != c->fmt_seq) {
+        uint64_t start = hdr->fmt_start_pos;
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&hdr->fmt_seq, memory_order_relaxed) == fs) {
+            c->fmt_seq = fs;
+            if (atomic_load_explicit(&c->read_pos, memory_order_relaxed) < start)
+                atomic_store_explicit(&c->read_pos, start, memory_order_release);
+            return AUDIO_BUS_FORMAT;
+        }
+    }
+
+    uint64_t r = atomic_load_explicit(&c->read_pos, memory_order_relaxed);
+    uint64_t w = atomic_load_explicit(&hdr->write_pos, memory_order_acquire);
+    if (w - r > size)
+        goto overrun;
+
+    uint64_t n = w - r;
+    if (n > max_frames) n = max_frames;
+    if (n == 0) return 0;
+
+    uint64_t off = r & (size - 1);
+    uint64_t first = (off + n > size) ? size - off : n;
+    memcpy(dst, ring + off * fb, first * fb);
+    if (n > first)
+        memcpy((uint8_t *)dst + first * fb, ring, (n - first) * fb);
+
+    /* Producer may have lapped us while we copied */
+    atomic_thread_fence(memory_order_acquire);
+    w = atomic_load_explicit(&hdr->write_claim, memory_order_relaxed);
+    if (w - r > size)
+        goto overrun;
+
+    atomic_store_explicit(&c->read_pos, r + n, memory_order_release);
+    return (long)n;
+
+overrun:
+    atomic_fetch_add_explicit(&c->overruns, 1, memory_order_relaxed);
+    atomic_store_explicit(&c->read_pos,
+        atomic_load_explicit(&hdr->write_pos, memory_order_acquire), memory_order_release);
+    return AUDIO_BUS_OVERRUN;
+}
+
+/* ── Producer side (uac2_router only) ───────────────────────────── */
+
+int  audio_bus_init(unsigned long ring_frames);     /* 0 = bus disabled */
+void audio_bus_exit(void);
+
+/* configure_audio(): new stream format, consumers resync */
+void audio_bus_set_format(unsigned int rate, unsigned int lrck_rate, int is_dsd);
+
+/* Audio thread: one copy into the ring, then wake attached consumers */
+void audio_bus_write(const void *frames, unsigned long n);
+
+/* Control thread: claim a slot for `pid`, return slot and the fds to pass */
+int  audio_bus_attach(int pid, int *memfd, int *eventfd);
+int  audio_bus_stats(char *out, size_t size);
+
+#endif /* AUDIO_BUS_H */
@@ -0,0 +1,143 @@
+/*
+ * uac2_pcm_bench — compare router PCM backends (alsa-lib vs direct ioctl)
+ *
+ * 1. open + hw/sw configure + close, repeated -n times
+ * 2. steady-state playback of silence for -p periods, measuring the
+ *    thread CPU time spent per period (syscalls included; time blocked
+ *    waiting for the DMA is not counted)
+ *
+ * Plays silence on the selected device — stop uac2_router first.
+ *
+ *   uac2_pcm_bench [-c card] [-d device] [-r rate] [-D] [-n opens] [-p periods]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <purecore/pcm_io.h>
+
+#define FMT_S32_LE      10      /* SNDRV_PCM_FORMAT_S32_LE */
+#define FMT_DSD_U32_LE  50      /* SNDRV_PCM_FORMAT_DSD_U32_LE */
+
+static uint64_t clock_ns(clockid_t id) {
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+struct result {
+    uint64_t open_min, open_max, open_sum;
+    int opens;
+    uint64_t period_cpu_ns;     /* average per period */
+    uint64_t period_wall_max;   /* worst writei duration */
+    int periods;
+};
+
+static int run(enum pcm_backend be, int card, int device,
+               const struct pcm_config *cfg, int n_opens, int n_periods,
+               struct result *r)
+{
+    struct pcm_io *io;
+    int err;
+
+    memset(r, 0, sizeof(*r));
+    r->open_min = UINT64_MAX;
+
+    for (int i = 0; i < n_opens; i++) {
+        uint64_t t0 = clock_ns(CLOCK_MONOTONIC);
+        if ((err = pcm_io_open(&io, be, card, device, PCM_IO_PLAYBACK, cfg)) < 0)
+            return err;
+        uint64_t dt = clock_ns(CLOCK_MONOTONIC) - t0;
+        pcm_io_close(io);
+
+        if (dt < r->open_min) r->open_min = dt;
+        if (dt > r->open_max) r->open_max = dt;
+        r->open_sum += dt;
+        r->opens++;
+    }
+
+    if ((err = pcm_io_open(&io, be, card, device, PCM_IO_PLAYBACK, cfg)) < 0)
+        return err;
+
+    size_t bytes = io->period_size * io->channels * 4;
+    char *silence = calloc(1, bytes);
+    if (cfg->format == FMT_DSD_U32_LE)
+        memset(silence, 0x69, bytes);   /* DSD idle pattern */
+
+    pcm_io_prepare(io);
+    uint64_t cpu0 = clock_ns(CLOCK_THREAD_CPUTIME_ID);
+    for (int i = 0; i < n_periods; i++) {
+        uint64_t t0 = clock_ns(CLOCK_MONOTONIC);
+        long wr = pcm_io_writei(io, silence, io->period_size);
+        uint64_t dt = clock_ns(CLOCK_MONOTONIC) - t0;
+        if (wr < 0) {
+            pcm_io_prepare(io);
+            continue;
+        }
+        if (dt > r->period_wall_max) r->period_wall_max = dt;
+        r->periods++;
+    }
+    /* Includes two vDSO clock_gettime() per period — tens of ns */
+    uint64_t cpu = clock_ns(CLOCK_THREAD_CPUTIME_ID) - cpu0;
+    r->period_cpu_ns = r->periods ? cpu / r->periods : 0;
+
+    pcm_io_close(io);
+    free(silence);
+    return 0;
+}
+
+static void print_result(const char *name, const struct result *r) {
+    printf("%-8s open+config: min %6llu us  avg %6llu us  max %6llu us   "
+           "period: %5llu ns CPU  (worst writei %llu us)\n",
+           name,
+           (unsigned long long)r->open_min / 1000,
+           (unsigned long long)(r->opens ? r->open_sum / r->opens : 0) / 1000,
+           (unsigned long long)r->open_max / 1000,
+           (unsigned long long)r->period_cpu_ns,
+           (unsigned long long)r->period_wall_max / 1000);
+}
+
+int main(int argc, char *argv[]) {
+    int card = 0, device = 0, n_opens = 20, n_periods = 1000, dsd = 0;
+    unsigned int rate = 192000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c:d:r:Dn:p:h")) != -1) {
+        switch (opt) {
+        case 'c': card = atoi(optarg); break;
+        case 'd': device = atoi(optarg); break;
+        case 'r': rate = strtoul(optarg, NULL, 10); break;
+        case 'D': dsd = 1; break;
+        case 'n': n_opens = atoi(optarg); break;
+        case 'p': n_periods = atoi(optarg); break;
+        default:
+            printf("Usage: %s [-c card] [-d device] [-r lrck_rate] [-D (DSD_U32_LE)] "
+                   "[-n opens] [-p periods]\n", argv[0]);
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    /* Same period/buffer the router asks for on I2S playback */
+    struct pcm_config cfg = {
+        .rate        = rate,
+        .format      = dsd ? FMT_DSD_U32_LE : FMT_S32_LE,
+        .channels    = 2,
+        .period_size = 512,
+        .buffer_size = dsd ? 32768 : 512 * 16,
+        .period_max  = dsd,
+    };
+
+    printf("hw:%d,%d %s %u Hz, %d opens, %d periods\n\n", card, device,
+           dsd ? "DSD_U32_LE" : "S32_LE", rate, n_opens, n_periods);
+
+    struct result r;
+    if (run(PCM_BACKEND_ALSA, card, device, &cfg, n_opens, n_periods, &r) == 0)
+        print_result("alsa", &r);
+    if (run(PCM_BACKEND_DIRECT, card, device, &cfg, n_opens, n_periods, &r) == 0)
+        print_result("direct", &r);
+    return 0;
+}
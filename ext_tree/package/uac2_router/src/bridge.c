@@ -0,0 +1,63 @@
+/*
+ * In-kernel bridge — see bridge.h
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bridge.h"
+
+static int attr_fd = -1;
+
+static int attr_write(const char *val) {
+    ssize_t len = strlen(val);
+    return pwrite(attr_fd, val, len, 0) == len ? 0 : -errno;
+}
+
+int bridge_start(const char *sysfs_dir, int card) {
+    char path[320], name[16];
+    int err;
+
+    snprintf(path, sizeof(path), "%s/i2s_bridge", sysfs_dir);
+    attr_fd = open(path, O_RDWR | O_CLOEXEC);
+    if (attr_fd < 0) {
+        fprintf(stderr, "[BRIDGE] %s: %s, routing in userspace\n", path, strerror(errno));
+        return -1;
+    }
+
+    snprintf(name, sizeof(name), "pcmC%dD0p", card);
+    err = attr_write(name);
+    if (err < 0) {
+        fprintf(stderr, "[BRIDGE] %s: %s, routing in userspace\n", name, strerror(-err));
+        close(attr_fd);
+        attr_fd = -1;
+        return -1;
+    }
+    printf("[BRIDGE] ISO OUT -> %s in the kernel\n", name);
+    return 0;
+}
+
+int bridge_status(struct bridge_status *st) {
+    char line[128];
+    ssize_t len;
+
+    if (attr_fd < 0) return -1;
+    len = pread(attr_fd, line, sizeof(line) - 1, 0);
+    if (len <= 0) return -1;
+    line[len] = '\0';
+    if (sscanf(line, "%15s %15s %lu %lu %lu", st->device, st->state,
+               &st->frames, &st->xruns, &st->overruns) != 5)
+        return -1;
+    return 0;
+}
+
+void bridge_stop(void) {
+    if (attr_fd < 0) return;
+    if (attr_write("off") == 0)
+        printf("[BRIDGE] Released\n");
+    close(attr_fd);
+    attr_fd = -1;
+}
@@ -0,0 +1,37 @@
+/*
+ * In-kernel bridge — u_audio writes ISO OUT straight to the I2S
+ *
+ * With BRIDGE=on the router does not route at all: it hands the I2S
+ * playback PCM to the gadget (<uac_card>/i2s_bridge) and stays on as a
+ * supervisor.  u_audio's completions fill a ring, a SCHED_FIFO kernel
+ * thread writes it to the I2S and follows rate and PCM/DSD changes,
+ * and the gadget's feedback PI runs on ring plus I2S buffer.  No
+ * capture PCM, no user-space wakeups, one copy per packet.
+ *
+ * The I2S driver's volume, mute and dsd_sample_swap sit in its
+ * user-copy path, which kernel writes do not take: the bridge is
+ * bit-perfect, local players and the sinks other than I2S are not
+ * available.  A patched u_audio only; without it the router routes.
+ */
+
+#ifndef BRIDGE_H
+#define BRIDGE_H
+
+struct bridge_status {
+    char device[16];                /* "pcmC0D0p", "off" */
+    char state[16];                 /* idle, priming or running */
+    unsigned long frames;           /* written to the I2S */
+    unsigned long xruns;            /* I2S underruns */
+    unsigned long overruns;         /* packets the ring had no room for */
+};
+
+/* Hand I2S card `card` to the gadget at `sysfs_dir`; 0 if it took it */
+int  bridge_start(const char *sysfs_dir, int card);
+
+/* 0 on success */
+int  bridge_status(struct bridge_status *st);
+
+/* Release the I2S */
+void bridge_stop(void);
+
+#endif /* BRIDGE_H */
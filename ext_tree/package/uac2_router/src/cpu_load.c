@@ -0,0 +1,75 @@
+/*
+ * Per-period CPU cost of the router audio loop — see cpu_load.h
+ */
+
+#include <string.h>
+#include <time.h>
+
+#include "cpu_load.h"
+
+static int enabled = 0;
+
+static uint64_t period_ns = 0;
+static unsigned long period_frames = 0;
+
+static uint64_t last_cpu_ns = 0;
+static int      have_last   = 0;
+static uint64_t win_max     = 0;
+static uint64_t win_sum     = 0;
+static unsigned int win_count = 0;
+
+static struct cpu_load_window last_window;
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void cpu_load_enable(void)  { enabled = 1; }
+int  cpu_load_enabled(void) { return enabled; }
+
+void cpu_load_configure(unsigned int lrck_rate, unsigned long frames) {
+    period_frames = frames;
+    period_ns = lrck_rate ? (uint64_t)frames * 1000000000ULL / lrck_rate : 0;
+    memset(&last_window, 0, sizeof(last_window));
+    cpu_load_reset();
+}
+
+void cpu_load_reset(void) {
+    have_last = 0;
+    win_max = 0;
+    win_sum = 0;
+    win_count = 0;
+}
+
+int cpu_load_period_done(struct cpu_load_window *w) {
+    if (!enabled) return 0;
+
+    uint64_t now = thread_cpu_ns();
+    if (!have_last) {
+        last_cpu_ns = now;
+        have_last = 1;
+        return 0;
+    }
+    uint64_t cost = now - last_cpu_ns;
+    last_cpu_ns = now;
+
+    if (cost > win_max) win_max = cost;
+    win_sum += cost;
+    if (++win_count < CPU_LOAD_WINDOW) return 0;
+
+    last_window.max_ns        = win_max;
+    last_window.avg_ns        = win_sum / win_count;
+    last_window.period_ns     = period_ns;
+    last_window.period_frames = period_frames;
+    last_window.util_permille = period_ns ? (unsigned int)(win_max * 1000 / period_ns) : 0;
+    *w = last_window;
+
+    win_max = 0;
+    win_sum = 0;
+    win_count = 0;
+    return 1;
+}
+
+const struct cpu_load_window *cpu_load_last(void) { return &last_window; }
@@ -0,0 +1,40 @@
+/*
+ * Per-period CPU cost of the router audio loop.
+ *
+ * One clock_gettime(CLOCK_THREAD_CPUTIME_ID) per capture period; the
+ * difference between consecutive calls is the CPU time the loop spent
+ * on that period, syscalls included.  Results are reduced to windows
+ * of CPU_LOAD_WINDOW periods for the schedulers that consume them
+ * (SCHED_DEADLINE budget, cpufreq policy).
+ */
+
+#ifndef CPU_LOAD_H
+#define CPU_LOAD_H
+
+#include <stdint.h>
+
+#define CPU_LOAD_WINDOW 256     /* periods per window */
+
+struct cpu_load_window {
+    uint64_t max_ns;            /* worst period in the window */
+    uint64_t avg_ns;
+    uint64_t period_ns;         /* wall-clock length of one period */
+    unsigned long period_frames;
+    unsigned int util_permille; /* max_ns / period_ns */
+};
+
+/* Measuring costs a syscall per period — off unless someone needs it */
+void cpu_load_enable(void);
+int  cpu_load_enabled(void);
+
+void cpu_load_configure(unsigned int lrck_rate, unsigned long period_frames);
+void cpu_load_reset(void);
+
+/* Account one steady-state period.  Returns 1 and fills *w when a
+ * window completes. */
+int  cpu_load_period_done(struct cpu_load_window *w);
+
+/* Last completed window (zeroed until the first one) */
+const struct cpu_load_window *cpu_load_last(void);
+
+#endif /* CPU_LOAD_H */
@@ -0,0 +1,161 @@
+/*
+ * Rate-aware CPU frequency policy — see cpufreq_policy.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "cpufreq_policy.h"
+
+#define CPUFREQ_SYSFS       "/sys/devices/system/cpu/cpu0/cpufreq"
+#define CPUFREQ_MAX_OPPS    16
+#define CPUFREQ_HOLD_WINDOWS 4      /* windows at max after a boost */
+
+static int active = 0;
+static int setspeed_fd = -1;
+static char saved_governor[32] = "";
+
+static unsigned int opps[CPUFREQ_MAX_OPPS];   /* kHz, ascending */
+static int n_opps = 0;
+static int cur_idx = -1;
+
+static unsigned int margin_pct = 100;
+static unsigned int full_lrck = 705600;
+static int pin_max = 0;                       /* stream floor is maximum */
+static unsigned int hold = 0;
+
+static int read_sysfs_str(const char *name, char *buf, size_t len) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", CPUFREQ_SYSFS, name);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    if (!fgets(buf, len, fp)) { fclose(fp); return -1; }
+    fclose(fp);
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+static int write_sysfs_str(const char *name, const char *val) {
+    char path[128];
+    snprintf(path, sizeof(path), "%s/%s", CPUFREQ_SYSFS, name);
+    FILE *fp = fopen(path, "w");
+    if (!fp) return -1;
+    int ok = fprintf(fp, "%s\n", val) > 0;
+    return (fclose(fp) == 0 && ok) ? 0 : -1;
+}
+
+static int cmp_uint(const void *a, const void *b) {
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+static int load_opps(void) {
+    char buf[256];
+    if (read_sysfs_str("scaling_available_frequencies", buf, sizeof(buf)) < 0)
+        return -1;
+    n_opps = 0;
+    for (char *tok = strtok(buf, " "); tok && n_opps < CPUFREQ_MAX_OPPS; tok = strtok(NULL, " ")) {
+        unsigned int khz = strtoul(tok, NULL, 10);
+        if (khz) opps[n_opps++] = khz;
+    }
+    qsort(opps, n_opps, sizeof(opps[0]), cmp_uint);
+    return n_opps > 0 ? 0 : -1;
+}
+
+static void set_idx(int idx) {
+    char buf[16];
+    if (idx == cur_idx) return;
+    int len = snprintf(buf, sizeof(buf), "%u", opps[idx]);
+    if (pwrite(setspeed_fd, buf, len, 0) == len)
+        cur_idx = idx;
+}
+
+int cpufreq_policy_init(const struct router_conf *conf) {
+    if (conf->cpufreq != ROUTER_CPUFREQ_ADAPTIVE)
+        return 0;
+
+    margin_pct = conf->cpufreq_margin_pct;
+    full_lrck  = conf->cpufreq_full_lrck;
+
+    if (load_opps() < 0) {
+        fprintf(stderr, "[CPUFREQ] WARNING: no OPP table, leaving governor alone\n");
+        return -1;
+    }
+    if (read_sysfs_str("scaling_governor", saved_governor, sizeof(saved_governor)) < 0 ||
+        write_sysfs_str("scaling_governor", "userspace") < 0) {
+        fprintf(stderr, "[CPUFREQ] WARNING: cannot select userspace governor\n");
+        return -1;
+    }
+    setspeed_fd = open(CPUFREQ_SYSFS "/scaling_setspeed", O_WRONLY | O_CLOEXEC);
+    if (setspeed_fd < 0) {
+        fprintf(stderr, "[CPUFREQ] WARNING: cannot open scaling_setspeed\n");
+        write_sysfs_str("scaling_governor", saved_governor);
+        return -1;
+    }
+
+    active = 1;
+    cpu_load_enable();
+    set_idx(n_opps - 1);
+    printf("[CPUFREQ] adaptive: %u..%u kHz, margin %u%%, full speed from LRCK %u\n",
+           opps[0], opps[n_opps - 1], margin_pct, full_lrck);
+    return 0;
+}
+
+void cpufreq_policy_exit(void) {
+    if (!active) return;
+    set_idx(n_opps - 1);
+    close(setspeed_fd);
+    setspeed_fd = -1;
+    if (saved_governor[0])
+        write_sysfs_str("scaling_governor", saved_governor);
+    active = 0;
+}
+
+void cpufreq_policy_boost(void) {
+    if (!active) return;
+    set_idx(n_opps - 1);
+    hold = CPUFREQ_HOLD_WINDOWS;
+}
+
+void cpufreq_policy_configure(unsigned int lrck_rate, int is_dsd) {
+    if (!active) return;
+    pin_max = lrck_rate >= full_lrck;
+    if (pin_max) set_idx(n_opps - 1);
+    printf("[CPUFREQ] %s stream at LRCK %u: %s\n", is_dsd ? "DSD" : "PCM",
+           lrck_rate, pin_max ? "pinned to maximum" : "adaptive");
+}
+
+void cpufreq_policy_window(const struct cpu_load_window *w) {
+    if (!active || cur_idx < 0 || !w->period_ns) return;
+
+    /* Cost above the period is a miss even if nothing XRUNed yet */
+    if (w->max_ns >= w->period_ns) {
+        cpufreq_policy_boost();
+        return;
+    }
+    if (pin_max) return;
+    if (hold) { hold--; return; }
+
+    /* Cycles are roughly constant per period: scale the measured cost
+     * to each OPP and keep the lowest one that leaves the margin. */
+    uint64_t cycles = w->max_ns * opps[cur_idx];
+    int want = n_opps - 1;
+    for (int i = 0; i < n_opps; i++) {
+        uint64_t cost = cycles / opps[i];
+        if (cost * (100 + margin_pct) / 100 <= w->period_ns) {
+            want = i;
+            break;
+        }
+    }
+
+    /* Up: jump straight there.  Down: one OPP per window. */
+    if (want < cur_idx) want = cur_idx - 1;
+    set_idx(want);
+}
+
+unsigned int cpufreq_policy_cur_khz(void) {
+    return (active && cur_idx >= 0) ? opps[cur_idx] : 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * Rate-aware CPU frequency policy.
+ *
+ * With CPUFREQ=adaptive the router takes cpu0 over from the kernel
+ * governor (switches it to "userspace") and sets the clock itself:
+ * the lowest OPP at which the measured per-period cost, scaled to that
+ * frequency, still leaves CPUFREQ_MARGIN headroom inside the period.
+ *
+ * The clock jumps to maximum before any reconfiguration and on any
+ * missed deadline (XRUN, SCHED_DEADLINE overrun), then steps down one
+ * OPP per load window after a short hold.  Streams at or above
+ * CPUFREQ_FULL_LRCK (DSD512, 705.6/768 kHz PCM) always run at maximum.
+ */
+
+#ifndef CPUFREQ_POLICY_H
+#define CPUFREQ_POLICY_H
+
+#include "router_conf.h"
+#include "cpu_load.h"
+
+int  cpufreq_policy_init(const struct router_conf *conf);
+void cpufreq_policy_exit(void);
+
+/* Jump to maximum and hold it for a few windows */
+void cpufreq_policy_boost(void);
+
+/* New stream: set the floor for this rate/format */
+void cpufreq_policy_configure(unsigned int lrck_rate, int is_dsd);
+
+/* Pick the OPP for the next window from a completed cpu_load window */
+void cpufreq_policy_window(const struct cpu_load_window *w);
+
+/* Current frequency in kHz (0 when the policy is not active) */
+unsigned int cpufreq_policy_cur_khz(void);
+
+#endif /* CPUFREQ_POLICY_H */
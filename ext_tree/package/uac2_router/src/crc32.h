@@ -0,0 +1,22 @@
+/*
+ * CRC-32 (IEEE 802.3, reflected 0xEDB88320) — same values as zlib's
+ * crc32() and Python's zlib.crc32(), so results can be checked anywhere.
+ *
+ * ARMv7 has no CRC32 instructions and the A7 no PMULL, so this is
+ * table-driven slice-by-8: 8 KiB of tables, 8 bytes per step, roughly
+ * 1.5 cycles/byte on the A7.  crc32_init() builds the tables and must
+ * run once before the audio thread goes real-time.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+void crc32_init(void);
+
+/* crc = crc32_update(0, buf, len) for a fresh CRC; chain the result */
+uint32_t crc32_update(uint32_t crc, const void *data, size_t len);
+
+#endif /* CRC32_H */
@@ -0,0 +1,574 @@
+/*
+ * Runtime control socket — see ctl_socket.h
+ *
+ * Two single-writer seqcount slots connect the threads:
+ *   request  control thread → audio thread  (tunables + reconfigure count)
+ *   stats    audio thread   → control thread
+ * Neither side ever waits for the other.  The control thread retries a
+ * read that races the audio thread.  The audio thread makes one attempt
+ * per period: on one core, spinning would only keep the lower-priority
+ * writer from finishing.  It only takes the request slot when its
+ * generation changed, so the idle cost is one atomic load.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "ctl_socket.h"
+#include "audio_bus.h"
+#include "recorder.h"
+#include "play_server.h"
+#include "feedback.h"
+
+#define CTL_LINE_MAX    128
+#define CTL_REPLY_MAX   8192        /* "stats" worst case is under 4 KiB */
+
+struct ctl_request {
+    struct router_tunables tun;
+    unsigned int reconfigure;       /* incremented per "reconfigure" */
+    unsigned int verify;            /* incremented per "verify start|stop" */
+};
+
+static atomic_uint req_seq;         /* odd while the control thread writes */
+static struct ctl_request req_slot;
+static unsigned int req_seen_seq;   /* audio thread only */
+static unsigned int req_seen_reconfigure;
+static unsigned int req_seen_verify;
+
+static atomic_uint stats_seq;       /* odd while the audio thread writes */
+static struct router_stats stats_slot;
+
+static int listen_fd = -1;
+static pthread_t ctl_thread;
+static int ctl_thread_started;
+static char sock_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+/* ── Seqcount slots ───────────────────────────────────────────────── */
+
+static void seq_write(atomic_uint *seq, void *slot, const void *val, size_t len) {
+    unsigned int s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(slot, val, len);
+    atomic_store_explicit(seq, s + 2, memory_order_release);
+}
+
+static unsigned int seq_read(atomic_uint *seq, const void *slot, void *val, size_t len) {
+    unsigned int s1, s2;
+    do {
+        s1 = atomic_load_explicit(seq, memory_order_acquire);
+        memcpy(val, slot, len);
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+    return s1;
+}
+
+/* One attempt; 0 if it raced the writer */
+static int seq_try_read(atomic_uint *seq, const void *slot, void *val, size_t len,
+                        unsigned int *out) {
+    unsigned int s1 = atomic_load_explicit(seq, memory_order_acquire);
+    if (s1 & 1) return 0;
+    memcpy(val, slot, len);
+    atomic_thread_fence(memory_order_acquire);
+    if (atomic_load_explicit(seq, memory_order_relaxed) != s1) return 0;
+    *out = s1;
+    return 1;
+}
+
+/* ── Audio thread side ────────────────────────────────────────────── */
+
+unsigned int ctl_socket_poll(struct router_tunables *tun) {
+    struct ctl_request req;
+    unsigned int apply = 0;
+
+    if (atomic_load_explicit(&req_seq, memory_order_relaxed) == req_seen_seq)
+        return 0;
+
+    /* Mid-update: try again at the next period boundary */
+    if (!seq_try_read(&req_seq, &req_slot, &req, sizeof(req), &req_seen_seq))
+        return 0;
+    if (memcmp(&req.tun, tun, sizeof(*tun)) != 0) {
+        *tun = req.tun;
+        apply |= CTL_APPLY_TUNABLES;
+    }
+    if (req.reconfigure != req_seen_reconfigure) {
+        req_seen_reconfigure = req.reconfigure;
+        apply |= CTL_APPLY_RECONFIGURE;
+    }
+    if (req.verify != req_seen_verify) {
+        req_seen_verify = req.verify;
+        apply |= CTL_APPLY_VERIFY;
+    }
+    return apply;
+}
+
+void ctl_socket_publish(const struct router_stats *st) {
+    seq_write(&stats_seq, &stats_slot, st, sizeof(*st));
+}
+
+/* ── Command handling (control thread) ────────────────────────────── */
+
+static struct ctl_request req_local;    /* control thread's copy of req_slot */
+
+static void request_commit(void) {
+    seq_write(&req_seq, &req_slot, &req_local, sizeof(req_local));
+}
+
+/* dBFS with one decimal, -inf floored at -199.9 */
+static double db(double ratio) {
+    return ratio > 1e-10 ? 20.0 * log10(ratio) : -199.9;
+}
+
+static int format_meter(const struct meter_window *m, char *out, size_t size) {
+    unsigned long silent_ms = (unsigned long)m->silent_windows * METER_WINDOW_MS;
+
+    if (m->state == METER_NONE || !m->frames)
+        return snprintf(out, size, "meter=none\n");
+    if (m->is_dsd)
+        return snprintf(out, size, "meter=%s density=%.1f,%.1f silent_ms=%lu\n",
+            meter_state_name(m->state),
+            100.0 * m->ones[0] / (m->frames * 32.0),
+            100.0 * m->ones[1] / (m->frames * 32.0), silent_ms);
+    return snprintf(out, size,
+        "meter=%s peak_db=%.1f,%.1f rms_db=%.1f,%.1f clips=%u silent_ms=%lu\n",
+        meter_state_name(m->state),
+        db(m->peak[0] / 2147483648.0), db(m->peak[1] / 2147483648.0),
+        db(sqrt((double)m->sumsq[0] / m->frames) / 32768.0),
+        db(sqrt((double)m->sumsq[1] / m->frames) / 32768.0),
+        m->clips, silent_ms);
+}
+
+static int format_verify(const struct verify_stats *v, char *out, size_t size) {
+    static const char *const names[2] = { "pre", "post" };
+    int len = snprintf(out, size, "verify=%s gaps=%lu\n", v->active ? "on" : "off", v->gaps);
+
+    for (int i = 0; i < 2 && v->active && len < (int)size; i++)
+        len += snprintf(out + len, size - len,
+                        "verify_%s=frames=%llu crc=0x%08x skipped=%llu\n", names[i],
+                        v->span[i].frames, (unsigned)v->span[i].crc, v->span[i].skipped);
+    return len;
+}
+
+/* End a reply with OK; one that did not fit ends in ERR instead */
+static int reply_ok(char *out, int len, size_t size) {
+    static const char trunc[] = "\nERR reply truncated\n";
+
+    if (len >= 0 && (size_t)len + 3 < size)
+        return len + snprintf(out + len, size - len, "OK\n");
+    memcpy(out + size - sizeof(trunc), trunc, sizeof(trunc));
+    return size - 1;
+}
+
+static int reply_stats(char *out, size_t size) {
+    struct router_stats st;
+    int len;
+
+    seq_read(&stats_seq, &stats_slot, &st, sizeof(st));
+
+    len = snprintf(out, size,
+        "rate=%u\nlrck=%u\ndsd=%d\n"
+        "capture_period=%lu\ncapture_buffer=%lu\n"
+        "playback_period=%lu\nplayback_buffer=%lu\nprebuffer_periods=%u\n"
+        "writes=%lu\nxruns=%lu\ncapture_xruns=%lu\ncapture_frames=%lu\n"
+        "reconfigures=%lu\nutil=%u.%u%%\ncpu_khz=%u\ndl_runtime_us=%llu\n"
+        "latency=%s\nlog=%d\nsource=%s\nsource_switches=%lu\n",
+        st.rate, st.lrck_rate, st.is_dsd,
+        st.cap_period, st.cap_buffer, st.pb_period, st.pb_buffer, st.prebuffer_periods,
+        st.write_count, st.xrun_count, st.cap_xrun_count, st.cap_frames_total,
+        st.reconfig_count, st.util_permille / 10, st.util_permille % 10, st.cpu_khz,
+        st.dl_runtime_ns / 1000,
+        pc_latency_name(st.tun.latency), st.tun.log_level,
+        st.source, st.source_switches);
+    for (unsigned int i = 0; i < st.nsinks && len < (int)size; i++) {
+        const struct router_sink_stats *sk = &st.sinks[i];
+        len += snprintf(out + len, size - len,
+            "sink%u=%s format=%s period=%lu writes=%lu xruns=%lu drops=%lu\n",
+            i, router_sink_name(sk->kind), sk->format ? sk->format : "offline",
+            sk->period, sk->writes, sk->xruns, sk->drops);
+    }
+    if (len < (int)size)
+        len += format_meter(&st.meter, out + len, size - len);
+    if (len < (int)size)
+        len += format_verify(&st.verify, out + len, size - len);
+    if (len < (int)size)
+        len += audio_bus_stats(out + len, size - len);
+    if (len < (int)size)
+        len += recorder_status(out + len, size - len);
+    if (len < (int)size)
+        len += play_server_stats(out + len, size - len);
+    if (len < (int)size)
+        len += feedback_stats(out + len, size - len);
+    return reply_ok(out, len, size);
+}
+
+static int handle_command(char *line, char *out, size_t size) {
+    char *cmd = strtok(line, " \t");
+    char *key = strtok(NULL, " \t");
+    char *val = strtok(NULL, " \t");
+    char *arg = strtok(NULL, " \t");
+
+    if (!cmd)
+        return 0;
+
+    if (strcmp(cmd, "help") == 0)
+        return snprintf(out, size,
+            "get latency|prebuffer|log|meter\n"
+            "set latency low|normal|safe\n"
+            "set prebuffer <periods, 0=default>\n"
+            "set log 0|1|2\n"
+            "stats\nreconfigure\n"
+            "bus (attach to the audio bus, fds via SCM_RIGHTS)\n"
+            "play <rate> [priority] [name] (local player ring, fds via SCM_RIGHTS)\n"
+            "sources\n"
+            "record [start [pre|post|both] [dir] | stop]\n"
+            "verify [start | stop]\nOK\n");
+
+    if (strcmp(cmd, "stats") == 0)
+        return reply_stats(out, size);
+
+    if (strcmp(cmd, "sources") == 0) {
+        struct router_stats st;
+        seq_read(&stats_seq, &stats_slot, &st, sizeof(st));
+        int len = snprintf(out, size, "source=%s\nusb_priority=%u\n", st.source, st.usb_priority);
+        if (len < (int)size)
+            len += play_server_stats(out + len, size - len);
+        return reply_ok(out, len, size);
+    }
+
+    if (strcmp(cmd, "reconfigure") == 0) {
+        req_local.reconfigure++;
+        request_commit();
+        return snprintf(out, size, "OK\n");
+    }
+
+    if (strcmp(cmd, "record") == 0) {
+        int err = 0;
+        if (!key) {
+            int len = recorder_status(out, size);
+            return reply_ok(out, len, size);
+        }
+        if (strcmp(key, "start") == 0) {
+            int streams = val ? recorder_parse_streams(val) : 0;
+            if (streams < 0) return snprintf(out, size, "ERR record: pre|post|both\n");
+            err = recorder_start(streams, arg);
+        } else if (strcmp(key, "stop") == 0) {
+            err = recorder_stop();
+        } else {
+            return snprintf(out, size, "ERR record: start|stop\n");
+        }
+        if (err < 0) return snprintf(out, size, "ERR record: %s\n", strerror(-err));
+        return snprintf(out, size, "OK\n");
+    }
+
+    if (strcmp(cmd, "verify") == 0) {
+        if (!key) {
+            struct router_stats st;
+            seq_read(&stats_seq, &stats_slot, &st, sizeof(st));
+            int len = format_verify(&st.verify, out, size);
+            return reply_ok(out, len, size);
+        }
+        if (strcmp(key, "start") == 0)
+            req_local.tun.verify = 1;
+        else if (strcmp(key, "stop") == 0)
+            req_local.tun.verify = 0;
+        else
+            return snprintf(out, size, "ERR verify: start|stop\n");
+        req_local.verify++;
+        request_commit();
+        return snprintf(out, size, "OK\n");
+    }
+
+    if (strcmp(cmd, "get") == 0 && key) {
+        if (strcmp(key, "latency") == 0)
+            return snprintf(out, size, "latency=%s\nOK\n",
+                            pc_latency_name(req_local.tun.latency));
+        if (strcmp(key, "prebuffer") == 0)
+            return snprintf(out, size, "prebuffer=%u\nOK\n", req_local.tun.prebuffer);
+        if (strcmp(key, "log") == 0)
+            return snprintf(out, size, "log=%d\nOK\n", req_local.tun.log_level);
+        if (strcmp(key, "meter") == 0) {
+            struct router_stats st;
+            seq_read(&stats_seq, &stats_slot, &st, sizeof(st));
+            int len = format_meter(&st.meter, out, size);
+            return reply_ok(out, len, size);
+        }
+        return snprintf(out, size, "ERR unknown key\n");
+    }
+
+    if (strcmp(cmd, "set") == 0 && key && val) {
+        char *end;
+        if (strcmp(key, "latency") == 0) {
+            int lat = pc_latency_parse(val);
+            if (lat < 0) return snprintf(out, size, "ERR latency: low|normal|safe\n");
+            req_local.tun.latency = lat;
+        } else if (strcmp(key, "prebuffer") == 0) {
+            unsigned long n = strtoul(val, &end, 10);
+            if (*end || n > 64) return snprintf(out, size, "ERR prebuffer: 0..64\n");
+            req_local.tun.prebuffer = n;
+        } else if (strcmp(key, "log") == 0) {
+            unsigned long lvl = strtoul(val, &end, 10);
+            if (*end || lvl > 2) return snprintf(out, size, "ERR log: 0..2\n");
+            req_local.tun.log_level = lvl;
+        } else {
+            return snprintf(out, size, "ERR unknown key\n");
+        }
+        request_commit();
+        return snprintf(out, size, "OK\n");
+    }
+
+    return snprintf(out, size, "ERR unknown command, try help\n");
+}
+
+/* Reply text plus fds via SCM_RIGHTS, in one message */
+static int send_fds(int fd, const char *text, int len, const int *fds, int nfds) {
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } cmsg;
+    struct iovec iov = { .iov_base = (void *)text, .iov_len = len };
+    struct msghdr msg = {
+        .msg_iov        = &iov,
+        .msg_iovlen     = 1,
+        .msg_control    = cmsg.buf,
+        .msg_controllen = CMSG_SPACE(nfds * sizeof(int)),
+    };
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    c->cmsg_level = SOL_SOCKET;
+    c->cmsg_type  = SCM_RIGHTS;
+    c->cmsg_len   = CMSG_LEN(nfds * sizeof(int));
+    memcpy(CMSG_DATA(c), fds, nfds * sizeof(int));
+
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == len ? 0 : -1;
+}
+
+static int send_text(int fd, const char *text) {
+    return send(fd, text, strlen(text), MSG_NOSIGNAL) < 0 ? -1 : 0;
+}
+
+static int peer_pid(int fd) {
+    struct ucred cred;
+    socklen_t cred_len = sizeof(cred);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) < 0)
+        return 0;
+    return cred.pid;
+}
+
+/* "bus": hand the memfd and a slot eventfd to the peer process */
+static int reply_bus(int fd) {
+    int fds[2];
+    char text[96];
+
+    int slot = audio_bus_attach(peer_pid(fd), &fds[0], &fds[1]);
+    if (slot < 0)
+        return send_text(fd, "ERR bus disabled or no free slot\n");
+
+    int len = snprintf(text, sizeof(text), "bus slot=%d\nOK\n", slot);
+    return send_fds(fd, text, len, fds, 2);
+}
+
+/* "play <rate> [priority] [name]": a ring for a local player (play_server.h) */
+static int reply_play(int fd, char *args) {
+    char *save, *end;
+    char *rate_s = strtok_r(args, " \t", &save);
+    char *prio_s = strtok_r(NULL, " \t", &save);
+    char *name   = strtok_r(NULL, " \t", &save);
+    unsigned long rate, prio = 50;
+    int fds[3];
+    char text[96];
+
+    if (!rate_s)
+        return send_text(fd, "ERR play <rate> [priority] [name]\n");
+    rate = strtoul(rate_s, &end, 10);
+    if (*end || rate < 8000 || rate > 24576000)
+        return send_text(fd, "ERR play: rate 8000..24576000\n");
+    if (prio_s) {
+        prio = strtoul(prio_s, &end, 10);
+        if (*end || prio > PLAY_PRIORITY_MAX)
+            return send_text(fd, "ERR play: priority 0..255\n");
+    }
+
+    int slot = play_server_attach(peer_pid(fd), rate, prio, name, fds);
+    if (slot < 0)
+        return send_text(fd, "ERR play disabled or no free slot\n");
+
+    int len = snprintf(text, sizeof(text), "play slot=%d\nOK\n", slot);
+    return send_fds(fd, text, len, fds, 3);
+}
+
+/* One client at a time; commands are short and the socket is root-only */
+static void serve_client(int fd) {
+    char in[CTL_LINE_MAX], out[CTL_REPLY_MAX];
+    size_t used = 0;
+
+    for (;;) {
+        ssize_t n = recv(fd, in + used, sizeof(in) - 1 - used, 0);
+        if (n <= 0) return;
+        used += n;
+        in[used] = '\0';
+
+        char *line = in, *nl;
+        while ((nl = strchr(line, '\n'))) {
+            *nl = '\0';
+            if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+            if (strcmp(line, "bus") == 0) {
+                if (reply_bus(fd) < 0) return;
+                line = nl + 1;
+                continue;
+            }
+            if (strncmp(line, "play", 4) == 0 && (!line[4] || line[4] == ' ')) {
+                if (reply_play(fd, line + 4) < 0) return;
+                line = nl + 1;
+                continue;
+            }
+            int len = handle_command(line, out, sizeof(out));
+            if (len > (int)sizeof(out) - 1) len = sizeof(out) - 1;
+            if (len > 0 && send(fd, out, len, MSG_NOSIGNAL) != len) return;
+            line = nl + 1;
+        }
+        used -= line - in;
+        memmove(in, line, used);
+        if (used == sizeof(in) - 1) {       /* overlong line */
+            send(fd, "ERR line too long\n", 18, MSG_NOSIGNAL);
+            return;
+        }
+    }
+}
+
+static void *ctl_thread_fn(void *arg) {
+    for (;;) {
+        int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;                          /* shut down by ctl_socket_stop() */
+        }
+        serve_client(fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+/* ── Lifecycle ────────────────────────────────────────────────────── */
+
+int ctl_socket_start(const char *path, const struct router_tunables *initial) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    pthread_attr_t attr;
+    struct sched_param sp = { .sched_priority = 0 };
+
+    req_local.tun = *initial;
+    req_local.reconfigure = 0;
+    request_commit();
+    req_seen_seq = atomic_load(&req_seq);
+
+    if (!path[0])
+        return 0;
+
+    snprintf(sock_path, sizeof(sock_path), "%s", path);
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        fprintf(stderr, "[CTL] socket: %s\n", strerror(errno));
+        return -1;
+    }
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(listen_fd, 2) < 0) {
+        fprintf(stderr, "[CTL] Cannot listen on %s: %s\n", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    chmod(path, 0600);
+
+    /* Never inherit the audio thread's RT policy */
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &sp);
+    int err = pthread_create(&ctl_thread, &attr, ctl_thread_fn, NULL);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        fprintf(stderr, "[CTL] Cannot start thread: %s\n", strerror(err));
+        close(listen_fd);
+        listen_fd = -1;
+        unlink(path);
+        return -1;
+    }
+    ctl_thread_started = 1;
+
+    printf("[CTL] Listening on %s\n", path);
+    return 0;
+}
+
+void ctl_socket_stop(void) {
+    if (listen_fd < 0) return;
+    shutdown(listen_fd, SHUT_RDWR);         /* wakes accept() */
+    if (ctl_thread_started) {
+        pthread_join(ctl_thread, NULL);
+        ctl_thread_started = 0;
+    }
+    close(listen_fd);
+    listen_fd = -1;
+    unlink(sock_path);
+}
+
+/* ── Client ───────────────────────────────────────────────────────── */
+
+int ctl_socket_client(const char *path, int argc, char **argv) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char cmd[CTL_LINE_MAX], buf[CTL_REPLY_MAX];
+    size_t len = 0;
+    int status = 1;
+
+    for (int i = 0; i < argc && len < sizeof(cmd) - 2; i++)
+        len += snprintf(cmd + len, sizeof(cmd) - 1 - len, "%s%s", i ? " " : "", argv[i]);
+    if (argc == 0)
+        len = snprintf(cmd, sizeof(cmd), "help");
+    if (len > sizeof(cmd) - 2) len = sizeof(cmd) - 2;
+    cmd[len++] = '\n';
+
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+    if (send(fd, cmd, len, MSG_NOSIGNAL) != (ssize_t)len) {
+        close(fd);
+        return 1;
+    }
+
+    /* Print until the terminating OK / ERR line */
+    size_t used = 0;
+    buf[0] = '\0';
+    for (;;) {
+        ssize_t n = recv(fd, buf + used, sizeof(buf) - 1 - used, 0);
+        if (n <= 0) break;
+        used += n;
+        buf[used] = '\0';
+        char *last = used > 1 ? memrchr(buf, '\n', used - 1) : NULL;
+        last = last ? last + 1 : buf;
+        if (buf[used - 1] == '\n' &&
+            (strncmp(last, "OK", 2) == 0 || strncmp(last, "ERR", 3) == 0)) {
+            status = last[0] == 'O' ? 0 : 1;
+            break;
+        }
+        if (used == sizeof(buf) - 1) break;
+    }
+    fputs(buf, status ? stderr : stdout);
+    close(fd);
+    return status;
+}
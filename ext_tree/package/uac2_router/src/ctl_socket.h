@@ -0,0 +1,87 @@
+/*
+ * Runtime control socket
+ *
+ * UNIX stream socket (CTL_SOCKET, default /run/uac2_router.sock) served
+ * by a SCHED_OTHER thread.  Line-based text protocol, one command per
+ * line, every reply ends with "OK" or "ERR <reason>":
+ *
+ *   get latency|prebuffer|log      current setting
+ *   get meter                      last level meter window (meter.h)
+ *   set latency low|normal|safe    playback period profile (reopens PCMs)
+ *   set prebuffer <periods>        0 = profile default
+ *   set log 0|1|2                  errors / +status line / +load windows
+ *   stats                          snapshot of the audio loop counters
+ *                                  and the last level meter window
+ *   reconfigure                    close and reopen all PCMs (re-probes sinks)
+ *   bus                            attach to the audio bus (audio_bus.h)
+ *   play <rate> [priority] [name]  attach a local player (play_server.h)
+ *   sources                        source on air and attached players
+ *   record [start [pre|post|both] [dir] | stop]
+ *                                  diagnostic recorder (recorder.h)
+ *   verify [start | stop]          bit-perfect CRCs (verify.h)
+ *   help
+ *
+ * The audio thread never blocks on the control thread: requests are
+ * handed over through a seqcount-protected slot and picked up with
+ * ctl_socket_poll() at the top of the loop, i.e. on a period boundary;
+ * stats flow back the same way through ctl_socket_publish().
+ *
+ * "uac2_router ctl <command...>" is a minimal client for shell use.
+ */
+
+#ifndef CTL_SOCKET_H
+#define CTL_SOCKET_H
+
+#include "router_conf.h"
+#include "meter.h"
+#include "verify.h"
+
+/* Per output sink, see sink.h */
+struct router_sink_stats {
+    enum router_sink kind;
+    const char *format;             /* static string, "offline" if closed */
+    unsigned long period;
+    unsigned long writes, xruns, drops;
+};
+
+/* Published by the audio loop once per period */
+struct router_stats {
+    unsigned int rate;              /* USB rate, DSD bit rate for DSD */
+    unsigned int lrck_rate;
+    int is_dsd;
+    unsigned long cap_period, pb_period;
+    unsigned long cap_buffer, pb_buffer;
+    unsigned int prebuffer_periods; /* effective, after clamping */
+    unsigned long write_count;
+    unsigned long xrun_count;
+    unsigned long cap_xrun_count;
+    unsigned long cap_frames_total;
+    unsigned long reconfig_count;
+    unsigned int util_permille;     /* last CPU load window, 0 if disabled */
+    unsigned int cpu_khz;
+    unsigned long long dl_runtime_ns;
+    struct router_tunables tun;     /* as applied */
+    unsigned int nsinks;
+    struct router_sink_stats sinks[ROUTER_MAX_SINKS];
+    struct meter_window meter;      /* last completed window */
+    struct verify_stats verify;
+    char source[24];                /* on air: "usb" or "local:<name>" */
+    unsigned long source_switches;
+    unsigned int usb_priority;
+};
+
+#define CTL_APPLY_TUNABLES      0x1     /* *tun holds new values */
+#define CTL_APPLY_RECONFIGURE   0x2     /* reopen PCMs at the current rate */
+#define CTL_APPLY_VERIFY        0x4     /* restart verification, tun->verify on/off */
+
+int  ctl_socket_start(const char *path, const struct router_tunables *initial);
+void ctl_socket_stop(void);
+
+/* Audio thread side — lock-free, no syscalls */
+unsigned int ctl_socket_poll(struct router_tunables *tun);
+void ctl_socket_publish(const struct router_stats *st);
+
+/* "uac2_router ctl ..." */
+int ctl_socket_client(const char *path, int argc, char **argv);
+
+#endif /* CTL_SOCKET_H */
@@ -0,0 +1,204 @@
+/*
+ * Drift seeds — see drift_seed.h
+ *
+ * File format, one host per line, rewritten whole (tmp + rename):
+ *   <family> <offset ppm> <seen>
+ * family "44.1k" or "48k"; seen orders the hosts of a family, the
+ * highest is the most recent.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <purecore/clock.h>
+
+#include "drift_seed.h"
+
+#define SEED_FAMILIES       2           /* 44.1k, 48k: index = family - 1 */
+#define SEED_PPM_MAX        400.0       /* u_audio FB_SEED_PPM_MAX */
+#define SEED_SAVE_PPM       0.5         /* smaller moves are not worth a flash write */
+
+struct seed_host {
+    double ppm;
+    unsigned long seen;             /* 0: slot empty */
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static char file[128];
+static struct seed_host hosts[SEED_FAMILIES][DRIFT_SEED_HOSTS];
+static unsigned long seen_counter;
+static int attr_fd[SEED_FAMILIES] = { -1, -1 };
+
+static const char *const attr_names[SEED_FAMILIES] = {
+    "feedback_seed_44k1",
+    "feedback_seed_48k",
+};
+
+static int family_index(unsigned int lrck_rate) {
+    switch (pc_clock_family(lrck_rate)) {
+    case PC_FAMILY_44K1: return 0;
+    case PC_FAMILY_48K:  return 1;
+    default:             return -1;
+    }
+}
+
+static struct seed_host *most_recent(int f) {
+    struct seed_host *best = NULL;
+    for (int i = 0; i < DRIFT_SEED_HOSTS; i++)
+        if (hosts[f][i].seen && (!best || hosts[f][i].seen > best->seen))
+            best = &hosts[f][i];
+    return best;
+}
+
+/* ── File ─────────────────────────────────────────────────────────── */
+
+static void load(void) {
+    char line[128], name[16];
+    double ppm;
+    unsigned long seen;
+    FILE *fp = fopen(file, "r");
+
+    if (!fp) return;
+    while (fgets(line, sizeof(line), fp)) {
+        if (sscanf(line, "%15s %lf %lu", name, &ppm, &seen) != 3 || !seen ||
+            fabs(ppm) > SEED_PPM_MAX)
+            continue;
+        int f = strcmp(name, "44.1k") == 0 ? 0 : strcmp(name, "48k") == 0 ? 1 : -1;
+        if (f < 0) continue;
+        for (int i = 0; i < DRIFT_SEED_HOSTS; i++) {
+            if (!hosts[f][i].seen) {
+                hosts[f][i].ppm  = ppm;
+                hosts[f][i].seen = seen;
+                break;
+            }
+        }
+        if (seen > seen_counter) seen_counter = seen;
+    }
+    fclose(fp);
+}
+
+static void save(void) {
+    char tmp[160];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+
+    FILE *fp = fopen(tmp, "w");
+    if (!fp) {
+        fprintf(stderr, "[SEED] Cannot write %s: %s\n", tmp, strerror(errno));
+        return;
+    }
+    fprintf(fp, "# uac2_router drift seeds: family offset_ppm seen\n");
+    for (int f = 0; f < SEED_FAMILIES; f++)
+        for (int i = 0; i < DRIFT_SEED_HOSTS; i++)
+            if (hosts[f][i].seen)
+                fprintf(fp, "%s %.2f %lu\n", pc_clock_family_name(f + 1),
+                        hosts[f][i].ppm, hosts[f][i].seen);
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+    if (rename(tmp, file) < 0)
+        fprintf(stderr, "[SEED] Cannot rename %s: %s\n", tmp, strerror(errno));
+}
+
+/* ── Gadget ───────────────────────────────────────────────────────── */
+
+static void apply(int f) {
+    char buf[16];
+    struct seed_host *h = most_recent(f);
+
+    if (attr_fd[f] < 0) return;
+    int len = snprintf(buf, sizeof(buf), "%ld\n", h ? lround(1000000.0 - h->ppm) : 0L);
+    if (pwrite(attr_fd[f], buf, len, 0) != len)
+        fprintf(stderr, "[SEED] %s: %s\n", attr_names[f], strerror(errno));
+}
+
+void drift_seed_init(const char *path) {
+    if (!path[0]) return;
+    snprintf(file, sizeof(file), "%s", path);
+    load();
+
+    for (int f = 0; f < SEED_FAMILIES; f++) {
+        struct seed_host *h = most_recent(f);
+        if (h)
+            printf("[SEED] %s: %+.2f ppm (%s)\n", pc_clock_family_name(f + 1), h->ppm, file);
+    }
+}
+
+void drift_seed_attach(const char *sysfs_dir) {
+    char path[300];
+
+    if (!file[0]) return;
+    pthread_mutex_lock(&lock);
+    for (int f = 0; f < SEED_FAMILIES; f++) {
+        if (attr_fd[f] >= 0) continue;
+        snprintf(path, sizeof(path), "%s/%s", sysfs_dir, attr_names[f]);
+        attr_fd[f] = open(path, O_WRONLY | O_CLOEXEC);
+        if (attr_fd[f] < 0) {
+            fprintf(stderr, "[SEED] No %s, streams start at nominal\n", path);
+            break;
+        }
+        apply(f);
+    }
+    pthread_mutex_unlock(&lock);
+}
+
+/* ── Seeds ────────────────────────────────────────────────────────── */
+
+int drift_seed_get(unsigned int lrck_rate, double *ppm) {
+    int f = family_index(lrck_rate), ret = -1;
+
+    if (!file[0] || f < 0) return -1;
+    pthread_mutex_lock(&lock);
+    struct seed_host *h = most_recent(f);
+    if (h) {
+        *ppm = h->ppm;
+        ret = 0;
+    }
+    pthread_mutex_unlock(&lock);
+    return ret;
+}
+
+void drift_seed_learn(unsigned int lrck_rate, double ppm) {
+    int f = family_index(lrck_rate);
+    struct seed_host *h = NULL, *oldest = NULL;
+
+    if (!file[0] || f < 0 || fabs(ppm) > SEED_PPM_MAX) return;
+
+    pthread_mutex_lock(&lock);
+    struct seed_host *recent = most_recent(f);
+    for (int i = 0; i < DRIFT_SEED_HOSTS; i++) {
+        struct seed_host *c = &hosts[f][i];
+        if (c->seen && fabs(c->ppm - ppm) <= DRIFT_SEED_MATCH_PPM &&
+            (!h || fabs(c->ppm - ppm) < fabs(h->ppm - ppm)))
+            h = c;
+        if (!oldest || c->seen < oldest->seen)
+            oldest = c;
+    }
+
+    int changed = 0;
+    if (!h) {
+        /* New host, or the slot of the least recently seen one */
+        printf("[SEED] %s: new host at %+.2f ppm\n", pc_clock_family_name(f + 1), ppm);
+        h = oldest;
+        h->ppm = ppm;
+        changed = 1;
+    } else if (fabs(h->ppm - ppm) >= SEED_SAVE_PPM) {
+        h->ppm = ppm;
+        changed = 1;
+    }
+    if (h != recent) {
+        h->seen = ++seen_counter;
+        changed = 1;
+    }
+    if (changed) {
+        save();
+        apply(f);
+    }
+    pthread_mutex_unlock(&lock);
+}
@@ -0,0 +1,45 @@
+/*
+ * Drift seeds — the host's clock offset, remembered across streams
+ *
+ * Every stream used to start at pitch 1000000 and re-converge from
+ * scratch, although the offset between the host's crystal and ours is
+ * a property of the pair and moves by a few ppm with temperature.  The
+ * feedback controller reports converged offsets here (feedback.c:
+ * estimator settled, or in FEEDBACK=kernel the gadget's pitch steady),
+ * per clock family:
+ *
+ *   store   DRIFT_SEEDS file (default /data/drift_seeds), up to
+ *           DRIFT_SEED_HOSTS hosts per family.  A converged offset
+ *           within DRIFT_SEED_MATCH_PPM of a known host is that host.
+ *   apply   <uac_card>/feedback_seed_44k1 and _48k get the most
+ *           recently seen host's pitch; u_audio starts the next stream
+ *           there and holds its PI for feedback_seed_hold.  The router's
+ *           own estimator starts from the same offset.
+ *
+ * The gadget cannot tell which host it is plugged into; the most recent
+ * one is the guess.  A wrong guess is caught by u_audio's emergency
+ * unfreeze (or the estimator's step detection) and learned as a new
+ * host.
+ */
+
+#ifndef DRIFT_SEED_H
+#define DRIFT_SEED_H
+
+#define DRIFT_SEED_HOSTS        4
+#define DRIFT_SEED_MATCH_PPM    15.0
+
+/* Startup: load `path` (empty: seeds off) */
+void drift_seed_init(const char *path);
+
+/* Gadget found: open its seed attributes and push the current seeds */
+void drift_seed_attach(const char *sysfs_dir);
+
+/* Offset (ppm, host faster > 0) of the most recent host in the clock
+ * family of `lrck_rate`; 0 if there is one */
+int  drift_seed_get(unsigned int lrck_rate, double *ppm);
+
+/* Converged offset for `lrck_rate`'s family: update or add the host,
+ * save and re-apply when it changed */
+void drift_seed_learn(unsigned int lrck_rate, double ppm);
+
+#endif /* DRIFT_SEED_H */
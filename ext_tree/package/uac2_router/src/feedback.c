@@ -0,0 +1,483 @@
+/*
+ * USB feedback control — see feedback.h
+ *
+ * Two single-writer seqcount slots, like ctl_socket.c:
+ *   sample  audio thread      → controller thread  (fill, set point epoch)
+ *   status  controller thread → control thread     ("ctl stats")
+ *
+ * The controller is libpurecore's drift estimator (purecore/drift.h):
+ * a Kalman filter over the timestamped fill that tracks the host/I2S
+ * clock offset and the fill error separately, so the pitch cancels the
+ * offset outright instead of integrating it out of a buffer excursion.
+ * Its continuous correction is noise-shaped to the integer ppm the
+ * gadget takes and slewed by at most FB_SLEW_PPM per step, so the host
+ * never sees a step in its rate.  The offset estimate survives a new
+ * set point; a change of clock family starts it from the drift seed
+ * for that family (drift_seed.h), or from scratch.
+ *
+ * Converged offsets go to drift_seed_learn(): in FEEDBACK=router once
+ * the estimator's offset σ is below FB_LEARN_SD_PPM, in FEEDBACK=kernel
+ * once the gadget's own pitch has stayed within FB_STEADY_PPM for
+ * FB_LEARN_SAMPLES (the thread only observes then).  Again every
+ * FB_RELEARN_SAMPLES while the stream runs.
+ *
+ * FEEDBACK=sof: the thread writes each sample's I2S position to
+ * clock_ref and observes like FEEDBACK=kernel.
+ *
+ * Observing reads the gadget's pitch from its status page
+ * (gadget_status.h), or from <uac_card>/feedback without one.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <alsa/asoundlib.h>
+
+#include <purecore/clock.h>
+#include <purecore/drift.h>
+
+#include "drift_seed.h"
+#include "feedback.h"
+#include "gadget_status.h"
+
+#define FB_PITCH_NOMINAL    PC_DRIFT_PITCH_NOMINAL
+#define FB_SLEW_PPM         200.0
+#define FB_LATCH_SAMPLES    (1000 / FEEDBACK_INTERVAL_MS)
+#define FB_LEARN_SAMPLES    (30000 / FEEDBACK_INTERVAL_MS)      /* 30 s locked */
+#define FB_RELEARN_SAMPLES  (600000 / FEEDBACK_INTERVAL_MS)     /* 10 min */
+#define FB_LEARN_SD_PPM     2.0
+#define FB_STEADY_PPM       2.0
+#define FB_PITCH_CTL        "Capture Pitch 1000000"
+
+enum fb_via {
+    FB_VIA_NONE = 0,
+    FB_VIA_SYSFS,
+    FB_VIA_CTL,
+};
+
+static const char *const via_names[] = {
+    [FB_VIA_NONE]  = "none",
+    [FB_VIA_SYSFS] = "sysfs",
+    [FB_VIA_CTL]   = "ctl",
+};
+
+struct fb_sample {
+    unsigned int epoch;             /* new set point when it changes */
+    unsigned int lrck_rate;
+    uint64_t t_ns;                  /* CLOCK_MONOTONIC of the measurement */
+    long fill;                      /* frames in flight through the router */
+    uint64_t played;                /* I2S frames played this epoch */
+};
+
+struct fb_status {
+    double pitch;                   /* continuous, before noise shaping */
+    double drift_ppm;               /* estimated host − I2S clock offset */
+    double fill_ms, target_ms, err_ms;
+    int locked;                     /* set point latched, estimator running */
+    unsigned int reacquired;        /* host clock steps detected */
+    unsigned long writes, write_errors;
+};
+
+static int enabled;                 /* FEEDBACK=router: we write the pitch */
+static int observe;                 /* FEEDBACK=kernel|sof with seeds: we read it */
+static int sof;                     /* FEEDBACK=sof: we report the I2S position */
+static atomic_int stop;
+static pthread_t thread;
+static int thread_started;
+
+/* Pitch output, set by feedback_attach() before the first sample */
+static enum fb_via via;
+static int sysfs_fd = -1;           /* <uac_card>/feedback, O_RDONLY if observing */
+static snd_ctl_t *ctl;
+static snd_ctl_elem_value_t *ctl_val;
+static int ref_fd = -1;             /* <uac_card>/clock_ref, FEEDBACK=sof */
+
+static atomic_uint sample_seq;      /* odd while the audio thread writes */
+static struct fb_sample sample_slot;
+
+static atomic_uint status_seq;      /* odd while the controller writes */
+static struct fb_status status_slot;
+
+/* Audio thread only */
+static unsigned int au_epoch;
+static unsigned int au_lrck;
+static int au_active;
+static unsigned long au_frames;
+static uint64_t au_written;         /* frames routed this epoch */
+
+/* ── Seqcount slots ───────────────────────────────────────────────── */
+
+static void seq_write(atomic_uint *seq, void *slot, const void *val, size_t len) {
+    unsigned int s = atomic_load_explicit(seq, memory_order_relaxed);
+    atomic_store_explicit(seq, s + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(slot, val, len);
+    atomic_store_explicit(seq, s + 2, memory_order_release);
+}
+
+static unsigned int seq_read(atomic_uint *seq, const void *slot, void *val, size_t len) {
+    unsigned int s1, s2;
+    do {
+        s1 = atomic_load_explicit(seq, memory_order_acquire);
+        memcpy(val, slot, len);
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+    return s1;
+}
+
+/* ── Audio thread ─────────────────────────────────────────────────── */
+
+void feedback_configure(unsigned int lrck_rate) {
+    au_lrck = lrck_rate;
+    feedback_hold();
+}
+
+void feedback_hold(void) {
+    au_active = 0;
+    au_frames = 0;
+    au_written = 0;
+}
+
+void feedback_update(struct pcm_io *capture, struct pcm_io *playback,
+                     unsigned long frames) {
+    long cap_avail, cap_delay, pb_avail, pb_delay;
+    struct timespec ts;
+
+    if (!thread_started || !au_lrck || !capture || !playback) return;
+
+    au_frames += frames;
+    au_written += frames;
+    if (au_frames < (unsigned long)au_lrck * FEEDBACK_INTERVAL_MS / 1000)
+        return;
+    au_frames = 0;
+
+    if (pcm_io_avail_delay(capture, &cap_avail, &cap_delay) < 0 ||
+        pcm_io_avail_delay(playback, &pb_avail, &pb_delay) < 0)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &ts);    /* vDSO, no syscall */
+    /* Bounded by the negotiated buffers; anything else is a glitch */
+    if (cap_avail < 0 || cap_avail > (long)capture->buffer_size ||
+        pb_delay < 0 || pb_delay > (long)playback->buffer_size)
+        return;
+
+    if (!au_active) {
+        au_active = 1;
+        au_epoch++;
+    }
+    struct fb_sample s = {
+        .epoch     = au_epoch,
+        .lrck_rate = au_lrck,
+        .t_ns      = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec,
+        .fill      = cap_avail + pb_delay,
+        .played    = au_written - pb_delay,
+    };
+    seq_write(&sample_seq, &sample_slot, &s, sizeof(s));
+}
+
+/* ── Pitch output ─────────────────────────────────────────────────── */
+
+static int write_pitch(unsigned int pitch) {
+    char buf[16];
+
+    switch (via) {
+    case FB_VIA_SYSFS: {
+        int len = snprintf(buf, sizeof(buf), "%u\n", pitch);
+        return pwrite(sysfs_fd, buf, len, 0) == len ? 0 : -errno;
+    }
+    case FB_VIA_CTL:
+        snd_ctl_elem_value_set_integer(ctl_val, 0, pitch);
+        return snd_ctl_elem_write(ctl, ctl_val);
+    default:
+        return -ENODEV;
+    }
+}
+
+void feedback_attach(int card, const char *sysfs_dir) {
+    char path[300];
+
+    drift_seed_attach(sysfs_dir);
+    if (!thread_started || via != FB_VIA_NONE || sysfs_fd >= 0) return;
+
+    if (sof && ref_fd < 0) {
+        snprintf(path, sizeof(path), "%s/clock_ref", sysfs_dir);
+        ref_fd = open(path, O_WRONLY | O_CLOEXEC);
+        if (ref_fd < 0)
+            fprintf(stderr, "[FB] No %s, gadget runs its fill loop\n", path);
+        else
+            printf("[FB] I2S position via %s\n", path);
+    }
+    snprintf(path, sizeof(path), "%s/feedback", sysfs_dir);
+    if (sof && !observe) return;    /* the gadget keeps its pitch */
+    if (observe) {
+        sysfs_fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (sysfs_fd < 0)
+            fprintf(stderr, "[FB] Cannot read %s, drift seeds not learned\n", path);
+        return;
+    }
+    sysfs_fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (sysfs_fd >= 0) {
+        via = FB_VIA_SYSFS;
+        printf("[FB] Pitch via %s\n", path);
+        return;
+    }
+
+    snprintf(path, sizeof(path), "hw:%d", card);
+    if (snd_ctl_open(&ctl, path, 0) == 0 && snd_ctl_elem_value_malloc(&ctl_val) == 0) {
+        snd_ctl_elem_value_set_interface(ctl_val, SND_CTL_ELEM_IFACE_PCM);
+        snd_ctl_elem_value_set_name(ctl_val, FB_PITCH_CTL);
+        if (snd_ctl_elem_read(ctl, ctl_val) == 0) {
+            via = FB_VIA_CTL;
+            printf("[FB] Pitch via %s \"%s\"\n", path, FB_PITCH_CTL);
+            return;
+        }
+    }
+    if (ctl_val) { snd_ctl_elem_value_free(ctl_val); ctl_val = NULL; }
+    if (ctl) { snd_ctl_close(ctl); ctl = NULL; }
+    fprintf(stderr, "[FB] No feedback control on card %d, gadget runs its own loop\n", card);
+}
+
+/* ── Controller thread ────────────────────────────────────────────── */
+
+/* FEEDBACK=sof: I2S position of the sample, for the gadget's ratio */
+static int report_position(const struct fb_sample *s) {
+    char buf[64];
+
+    if (ref_fd < 0) { errno = EAGAIN; return -1; }
+    int len = snprintf(buf, sizeof(buf), "%u %llu %llu\n", s->epoch,
+                       (unsigned long long)s->played, (unsigned long long)s->t_ns);
+    return pwrite(ref_fd, buf, len, 0) == len ? 0 : -1;
+}
+
+/* FEEDBACK=kernel: learn from the gadget's pitch once it holds still */
+static void observe_step(const struct fb_sample *s, unsigned int *epoch,
+                         struct fb_status *st) {
+    static double lo, hi, sum;
+    static unsigned int n, since_learn;
+    struct gadget_status gs;
+    double pitch;
+
+    if (gadget_status_read(&gs) == 0) {
+        pitch = gs.pitch;
+    } else {
+        char buf[16] = "";
+
+        if (sysfs_fd < 0 || pread(sysfs_fd, buf, sizeof(buf) - 1, 0) <= 0)
+            return;
+        pitch = strtod(buf, NULL);
+    }
+
+    /* Window restarts when the spread would exceed ±FB_STEADY_PPM */
+    if (s->epoch != *epoch || n == 0 ||
+        pitch > lo + 2 * FB_STEADY_PPM || pitch < hi - 2 * FB_STEADY_PPM) {
+        *epoch = s->epoch;
+        lo = hi = sum = pitch;
+        n = 1;
+        since_learn = 0;
+    } else {
+        if (pitch < lo) lo = pitch;
+        if (pitch > hi) hi = pitch;
+        sum += pitch;
+        n++;
+    }
+    st->pitch = pitch;
+    st->locked = n >= FB_LEARN_SAMPLES;
+    if (n >= FB_LEARN_SAMPLES && since_learn++ % FB_RELEARN_SAMPLES == 0) {
+        st->drift_ppm = FB_PITCH_NOMINAL - sum / n;
+        drift_seed_learn(s->lrck_rate, st->drift_ppm);
+    }
+}
+
+static void *controller_fn(void *arg) {
+    const struct timespec tick = { 0, FEEDBACK_INTERVAL_MS * 1000000L };
+    struct fb_status st = { .pitch = FB_PITCH_NOMINAL };
+    struct pc_drift drift;
+    unsigned int last_seq = 0, epoch = 0, lrck = 0, learn_at = 0;
+    double latch_sum = 0.0, pitch = FB_PITCH_NOMINAL;
+    long target = 0;
+    int latched = 0;
+
+    while (!atomic_load(&stop)) {
+        struct fb_sample s;
+
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &tick, NULL);
+        unsigned int seq = seq_read(&sample_seq, &sample_slot, &s, sizeof(s));
+        if (seq == last_seq || (via == FB_VIA_NONE && !observe && !sof) || !s.lrck_rate) {
+            /* Not routing USB: stay quiet, the gadget's loop takes over */
+            st.locked = 0;
+            seq_write(&status_seq, &status_slot, &st, sizeof(st));
+            continue;
+        }
+        last_seq = seq;
+
+        if (sof) {
+            /* EAGAIN: the gadget is not counting microframes (yet) */
+            if (report_position(&s) < 0 && errno != EAGAIN)
+                st.write_errors++;
+            else
+                st.writes++;
+        }
+        if (observe) {
+            observe_step(&s, &epoch, &st);
+        }
+        if (observe || sof) {
+            seq_write(&status_seq, &status_slot, &st, sizeof(st));
+            continue;
+        }
+
+        /* New rate: within a clock family the offset in ppm carries
+         * over (same two crystals); across families start from the
+         * family's seed, which the gadget already started from too */
+        if (s.lrck_rate != lrck) {
+            double seed = 0.0;
+            if (lrck && pc_clock_family(lrck) == pc_clock_family(s.lrck_rate)) {
+                seed = drift.d;
+            } else {
+                drift_seed_get(s.lrck_rate, &seed);
+                pitch = FB_PITCH_NOMINAL - seed;
+            }
+            pc_drift_init(&drift, s.lrck_rate, seed);
+            lrck = s.lrck_rate;
+        }
+        /* New operating point: re-latch the set point, keep the offset
+         * estimate — it is the host/I2S clock offset, not the fill */
+        if (s.epoch != epoch) {
+            epoch     = s.epoch;
+            latched   = 0;
+            latch_sum = 0.0;
+            pc_drift_reset_fill(&drift);
+        }
+        if (latched < FB_LATCH_SAMPLES) {
+            latch_sum += s.fill;
+            if (++latched == FB_LATCH_SAMPLES) {
+                target   = lround(latch_sum / FB_LATCH_SAMPLES);
+                learn_at = FB_LEARN_SAMPLES;
+            }
+        } else {
+            double err = (double)(s.fill - target);
+            double u = pc_drift_update(&drift, s.t_ns, err);
+
+            /* Fill above the set point: host too fast, report less */
+            double want = FB_PITCH_NOMINAL - u;
+            if (want > pitch + FB_SLEW_PPM) want = pitch + FB_SLEW_PPM;
+            if (want < pitch - FB_SLEW_PPM) want = pitch - FB_SLEW_PPM;
+            pitch = want;
+            st.err_ms = err * 1000.0 / s.lrck_rate;
+
+            /* Settled long enough and sure of the offset: remember it */
+            if (learn_at && --learn_at == 0) {
+                if (sqrt(drift.p[1][1]) < FB_LEARN_SD_PPM) {
+                    drift_seed_learn(s.lrck_rate, drift.d);
+                    learn_at = FB_RELEARN_SAMPLES;
+                } else {
+                    learn_at = FB_LATCH_SAMPLES;
+                }
+            }
+        }
+        /* Written every step: a sysfs write holds the kernel PI off */
+        if (write_pitch(pc_drift_quantize(&drift, pitch)) < 0)
+            st.write_errors++;
+        else
+            st.writes++;
+
+        st.pitch      = pitch;
+        st.drift_ppm  = drift.d;
+        st.reacquired = drift.reacquired;
+        st.locked     = latched >= FB_LATCH_SAMPLES;
+        st.fill_ms    = s.fill * 1000.0 / s.lrck_rate;
+        st.target_ms  = st.locked ? target * 1000.0 / s.lrck_rate : 0.0;
+        seq_write(&status_seq, &status_slot, &st, sizeof(st));
+    }
+    return NULL;
+}
+
+int feedback_init(const struct router_conf *conf) {
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_attr_t attr;
+
+    drift_seed_init(conf->drift_seeds);
+    enabled = conf->feedback == ROUTER_FEEDBACK_ROUTER;
+    sof     = conf->feedback == ROUTER_FEEDBACK_SOF;
+    if (!enabled) {
+        printf("[FB] Feedback left to the gadget (FEEDBACK=%s)\n", sof ? "sof" : "kernel");
+        /* Still worth watching it converge, for the seeds */
+        observe = conf->drift_seeds[0] != '\0';
+        if (!observe && !sof) return 0;
+    }
+
+    /* Never inherit the audio thread's RT policy */
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &sp);
+    int err = pthread_create(&thread, &attr, controller_fn, NULL);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        fprintf(stderr, "[FB] Cannot start thread: %s\n", strerror(err));
+        enabled = observe = sof = 0;
+        return -1;
+    }
+    thread_started = 1;
+    return 0;
+}
+
+void feedback_exit(void) {
+    if (thread_started) {
+        atomic_store(&stop, 1);
+        pthread_join(thread, NULL);
+        thread_started = 0;
+    }
+    if (sysfs_fd >= 0) { close(sysfs_fd); sysfs_fd = -1; }
+    if (ref_fd >= 0) { close(ref_fd); ref_fd = -1; }
+    if (ctl_val) { snd_ctl_elem_value_free(ctl_val); ctl_val = NULL; }
+    if (ctl) { snd_ctl_close(ctl); ctl = NULL; }
+    via = FB_VIA_NONE;
+}
+
+/* ── Control thread ───────────────────────────────────────────────── */
+
+/* The gadget's own loop, from its status page: the fill its PI runs on */
+static int gadget_stats(char *out, size_t size) {
+    struct gadget_status gs;
+
+    if (gadget_status_read(&gs) < 0 || !(gs.flags & GADGET_STATUS_FILL))
+        return snprintf(out, size, "\n");
+    return snprintf(out, size, " gadget_fill=%d gadget_target=%d gadget_buffer=%u%s\n",
+                    gs.fill, gs.target, gs.buffer_size,
+                    gs.flags & GADGET_STATUS_BRIDGE ? " gadget_bridge=1" : "");
+}
+
+int feedback_stats(char *out, size_t size) {
+    struct fb_status st;
+    int n;
+
+    if (!enabled && !observe && !sof) {
+        n = snprintf(out, size, "feedback=kernel");
+    } else {
+        seq_read(&status_seq, &status_slot, &st, sizeof(st));
+        if (sof)
+            n = snprintf(out, size,
+                "feedback=sof reports=%lu report_errors=%lu steady=%d pitch=%.2f drift_ppm=%.2f",
+                st.writes, st.write_errors, st.locked, st.pitch, st.drift_ppm);
+        else if (observe)
+            n = snprintf(out, size, "feedback=kernel steady=%d pitch=%.2f drift_ppm=%.2f",
+                         st.locked, st.pitch, st.drift_ppm);
+        else
+            return snprintf(out, size,
+                "feedback=router via=%s locked=%d pitch=%.2f drift_ppm=%.2f fill_ms=%.2f "
+                "target_ms=%.2f err_ms=%.3f reacquired=%u writes=%lu write_errors=%lu\n",
+                via_names[via], st.locked, st.pitch, st.drift_ppm, st.fill_ms,
+                st.target_ms, st.err_ms, st.reacquired, st.writes, st.write_errors);
+    }
+    /* The gadget runs the loop: show what it runs on */
+    if (n < 0 || (size_t)n >= size) return n;
+    return n + gadget_stats(out + n, size - n);
+}
@@ -0,0 +1,68 @@
+/*
+ * USB feedback control — the host's clock follows the I2S clock
+ *
+ * Replaces the standalone buffer_daemon, which parsed
+ * /proc/asound/card0/pcm0p/sub0/status and assumed a 16384-frame
+ * buffer.  Here the audio thread measures the frames in flight through
+ * the router directly, on the handles it already holds:
+ *
+ *   fill = capture avail (received, not yet read)
+ *        + playback delay (written, not yet played)
+ *
+ * once every FEEDBACK_INTERVAL_MS, at the same point of the loop so the
+ * per-period sawtooth does not alias into the measurement.  A drift
+ * estimator (libpurecore, purecore/drift.h) on a SCHED_OTHER thread
+ * turns the timestamped fill into the gadget's feedback pitch (ppm
+ * around 1000000):
+ *
+ *   sysfs  <uac_card>/feedback, persistent fd — a write holds the
+ *          in-kernel PI off for ~2 s (u_audio "feedback" attribute)
+ *   ctl    "Capture Pitch 1000000" on the gadget card — stock u_audio
+ *
+ * The set point is the fill averaged over the first second after the
+ * primary sink starts or capture restarts, so the loop holds the
+ * latency the stream started with (pre-buffer plus one capture period)
+ * instead of a fixed ratio.
+ * While the router does not route USB (local player on air, sinks
+ * pre-buffering) nothing is written and the gadget's own loop takes
+ * over again.
+ *
+ * FEEDBACK=router (default) or kernel (leave the gadget alone).
+ * FEEDBACK=sof leaves the loop in the gadget too but feeds it the clock:
+ * every sample the I2S frames played so far (frames routed − playback
+ * delay) and their timestamp go to <uac_card>/clock_ref, which u_audio
+ * measures against the USB microframe count; the ratio is the feedback
+ * value and its fill PI only trims it.
+ */
+
+#ifndef FEEDBACK_H
+#define FEEDBACK_H
+
+#include <stddef.h>
+
+#include <purecore/pcm_io.h>
+
+#include "router_conf.h"
+
+#define FEEDBACK_INTERVAL_MS    100
+
+/* Startup, before real-time: starts the controller thread (idle) */
+int  feedback_init(const struct router_conf *conf);
+void feedback_exit(void);
+
+/* Gadget card found: ALSA card number and its /sys/class/u_audio dir */
+void feedback_attach(int card, const char *sysfs_dir);
+
+/* Audio thread — no syscalls except the two avail/delay queries (and a
+ * vDSO clock read) per FEEDBACK_INTERVAL_MS in feedback_update().
+ * feedback_hold() marks the operating point as gone (XRUN, capture
+ * restart, source switch); the next update starts a new measurement and
+ * a new set point. */
+void feedback_configure(unsigned int lrck_rate);    /* sinks (re)opened */
+void feedback_update(struct pcm_io *capture, struct pcm_io *playback,
+                     unsigned long frames);         /* after each USB period */
+void feedback_hold(void);
+
+int  feedback_stats(char *out, size_t size);
+
+#endif /* FEEDBACK_H */
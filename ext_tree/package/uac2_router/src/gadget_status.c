@@ -0,0 +1,101 @@
+/*
+ * Gadget status page — see gadget_status.h
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+
+#include "gadget_status.h"
+
+static const struct gadget_status *page;
+static size_t page_size;
+static int event_fd = -1;
+
+static const char *const event_names[] = {
+    [GADGET_EVENT_SET_RATE]   = "SET_RATE",
+    [GADGET_EVENT_ALT_CHANGE] = "ALT_CHANGE",
+    [GADGET_EVENT_START]      = "START",
+    [GADGET_EVENT_STOP]       = "STOP",
+    [GADGET_EVENT_VOLUME]     = "VOLUME",
+    [GADGET_EVENT_MUTE]       = "MUTE",
+};
+
+int gadget_status_open(int card) {
+    char path[32];
+    void *p;
+
+    if (page) return 0;
+    snprintf(path, sizeof(path), "/dev/uac_card%d", card);
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "[GADGET] No %s, status from sysfs only\n", path);
+        return -1;
+    }
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+    p = mmap(NULL, page_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+        fprintf(stderr, "[GADGET] Cannot map %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    page = p;
+    event_fd = fd;                  /* events from the next one on */
+    if (page->magic != GADGET_STATUS_MAGIC || page->version != GADGET_STATUS_VERSION) {
+        fprintf(stderr, "[GADGET] %s: layout %#x v%u, want v%u\n", path,
+                page->magic, page->version, GADGET_STATUS_VERSION);
+        gadget_status_close();
+        return -1;
+    }
+    printf("[GADGET] Status page and events %s\n", path);
+    return 0;
+}
+
+void gadget_status_close(void) {
+    if (page) munmap((void *)page, page_size);
+    page = NULL;
+    if (event_fd >= 0) close(event_fd);
+    event_fd = -1;
+}
+
+int gadget_status_read(struct gadget_status *out) {
+    const _Atomic uint32_t *seq;
+    uint32_t s1, s2;
+
+    if (!page) return -1;
+    seq = (const _Atomic uint32_t *)&page->seq;
+    do {
+        s1 = atomic_load_explicit(seq, memory_order_acquire);
+        memcpy(out, page, sizeof(*out));
+        atomic_thread_fence(memory_order_acquire);
+        s2 = atomic_load_explicit(seq, memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+    return 0;
+}
+
+int gadget_event_fd(void) {
+    return event_fd;
+}
+
+int gadget_event_read(struct gadget_event *ev) {
+    if (event_fd < 0) return -1;
+    ssize_t n = read(event_fd, ev, sizeof(*ev));
+    if (n == (ssize_t)sizeof(*ev)) return 1;
+    if (n < 0 && errno == EAGAIN) return 0;
+    /* EOF: the gadget was unbound; a short read cannot happen */
+    fprintf(stderr, "[GADGET] Event channel closed\n");
+    close(event_fd);
+    event_fd = -1;
+    return -1;
+}
+
+const char *gadget_event_name(unsigned int type) {
+    if (type < sizeof(event_names) / sizeof(event_names[0]) && event_names[type])
+        return event_names[type];
+    return "?";
+}
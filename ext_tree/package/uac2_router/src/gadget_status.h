@@ -0,0 +1,100 @@
+/*
+ * Gadget status page — u_audio's state without a syscall
+ *
+ * /dev/uac_card<N> maps one read-only page the gadget rewrites at
+ * stream start and on every feedback completion (1 ms): the capture
+ * ring position, the fill its PI sees, pitch and PI state, rate,
+ * alt setting and the ISO OUT counters of the debugfs stats.  A reader
+ * copies it under the page's seqcount, so it can sample at any rate
+ * without a sysfs read or a uevent.  time_ns stops advancing while no
+ * stream runs.
+ *
+ * The same device delivers the gadget's stream changes: read() returns
+ * whole struct gadget_event records, each with the complete stream
+ * descriptor after the change, so a reader drains what is pending and
+ * acts once on the last one — no uevent, no sysfs text, no window
+ * between the rate change and the alt switch.  poll() it for POLLIN.
+ *
+ * The layouts are struct uac_status_page and struct uac_event in
+ * u_audio.c (kernel patch); keep both in step and bump the version on
+ * both sides.
+ */
+
+#ifndef GADGET_STATUS_H
+#define GADGET_STATUS_H
+
+#include <stdint.h>
+
+#define GADGET_STATUS_MAGIC     0x53434155u     /* "UACS" */
+#define GADGET_STATUS_VERSION   1
+
+#define GADGET_STATUS_FILL      (1u << 0)       /* fill, target, buffer_size valid */
+#define GADGET_STATUS_BRIDGE    (1u << 1)       /* the fill is the i2s_bridge's */
+#define GADGET_STATUS_SOF       (1u << 2)       /* feedback from the clock ratio */
+
+struct gadget_status {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;                   /* odd while the gadget writes */
+    uint32_t flags;                 /* GADGET_STATUS_* */
+    uint64_t time_ns;               /* CLOCK_MONOTONIC of the update */
+    uint32_t srate;                 /* capture LRCK rate */
+    uint32_t as_out_alt;            /* 1 PCM, 2 DSD */
+    uint32_t hw_ptr;                /* capture ring, bytes */
+    uint32_t buffer_size;           /* frames */
+    int32_t fill;                   /* frames */
+    int32_t target;                 /* frames, the PI's set point */
+    uint32_t pitch;                 /* 1000000 = nominal */
+    int32_t fb_err_smooth;          /* fill error, frames Q8 */
+    int64_t fb_integral;            /* ppm Q32 */
+    uint32_t fb_freeze;             /* PI held for this many cycles */
+    uint32_t feedback;              /* value sent on the feedback endpoint */
+    uint64_t fb_sent;
+    uint64_t completions;           /* ISO OUT */
+    uint64_t zlp, short_pkts, errors, gaps;
+    uint64_t trunc_bytes;
+};
+
+enum gadget_event_type {
+    GADGET_EVENT_SET_RATE = 1,      /* value: the LRCK rate the host set */
+    GADGET_EVENT_ALT_CHANGE,        /* value: the alt setting */
+    GADGET_EVENT_START,
+    GADGET_EVENT_STOP,
+    GADGET_EVENT_VOLUME,            /* value: 1/256 dB */
+    GADGET_EVENT_MUTE,              /* value: 0 or 1 */
+};
+
+struct gadget_event {
+    uint32_t seq;                   /* from 1, per card */
+    uint16_t type;                  /* enum gadget_event_type */
+    uint16_t dir;                   /* 0 capture (ISO OUT), 1 playback */
+    int32_t value;
+    uint32_t dropped;               /* events lost just before this one */
+    uint64_t time_ns;               /* CLOCK_MONOTONIC */
+    uint32_t rate;                  /* as <uac_card>/rate: DSD bit rate for DSD */
+    uint32_t c_srate;               /* capture LRCK rate */
+    uint32_t p_srate;
+    uint8_t as_out_alt;             /* 0 idle, 1 PCM, 2 DSD */
+    uint8_t c_ssize;                /* bytes per sample */
+    uint8_t c_channels;
+    uint8_t c_active;               /* host streaming ISO OUT */
+    uint8_t p_ssize;
+    uint8_t p_channels;
+    uint8_t p_active;
+    uint8_t reserved[5];
+};
+
+/* Gadget found: map /dev/uac_card<card>; -1 with a stock u_audio */
+int  gadget_status_open(int card);
+void gadget_status_close(void);
+
+/* Consistent copy of the page; -1 when not mapped */
+int  gadget_status_read(struct gadget_status *out);
+
+/* Event channel: fd to poll (-1 without one); next pending event,
+ * 1 if there was one, 0 if none, -1 without a channel */
+int  gadget_event_fd(void);
+int  gadget_event_read(struct gadget_event *ev);
+const char *gadget_event_name(unsigned int type);
+
+#endif /* GADGET_STATUS_H */
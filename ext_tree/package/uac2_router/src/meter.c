@@ -0,0 +1,192 @@
+/*
+ * Level metering — see meter.h
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define METER_NEON 1
+#endif
+
+#include <purecore/swap.h>
+
+#include "meter.h"
+
+struct meter_acc {
+    unsigned long frames;
+    uint32_t peak[2];
+    uint64_t sumsq[2];
+    uint32_t clips;
+    uint32_t ones[2];
+    uint32_t pattern[2];        /* DSD: first word of the window */
+    int constant;               /* DSD: every word equals pattern so far */
+};
+
+static struct meter_acc acc;
+static unsigned long window_frames = 4410;
+static int cur_dsd;
+static unsigned int silent_windows;
+
+void meter_configure(unsigned int lrck_rate, int is_dsd) {
+    memset(&acc, 0, sizeof(acc));
+    window_frames  = (unsigned long)lrck_rate * METER_WINDOW_MS / 1000;
+    if (!window_frames) window_frames = 1;
+    cur_dsd        = is_dsd;
+    silent_windows = 0;
+}
+
+static int window_done(struct meter_window *w) {
+    if (acc.frames < window_frames) return 0;
+
+    w->is_dsd   = cur_dsd;
+    w->frames   = acc.frames;
+    w->peak[0]  = acc.peak[0];
+    w->peak[1]  = acc.peak[1];
+    w->sumsq[0] = acc.sumsq[0];
+    w->sumsq[1] = acc.sumsq[1];
+    w->clips    = acc.clips;
+    w->ones[0]  = acc.ones[0];
+    w->ones[1]  = acc.ones[1];
+
+    if (cur_dsd)
+        w->state = (acc.constant && __builtin_popcount(acc.pattern[0]) == 16 &&
+                    __builtin_popcount(acc.pattern[1]) == 16)
+                   ? METER_DSD_IDLE : METER_SIGNAL;
+    else
+        w->state = (acc.peak[0] < METER_SILENCE_PEAK && acc.peak[1] < METER_SILENCE_PEAK)
+                   ? METER_SILENCE : METER_SIGNAL;
+
+    silent_windows = w->state == METER_SIGNAL ? 0 : silent_windows + 1;
+    w->silent_windows = silent_windows;
+
+    memset(&acc, 0, sizeof(acc));
+    return 1;
+}
+
+/* ── PCM ──────────────────────────────────────────────────────────── */
+
+static inline void pcm_sample(int ch, int32_t s) {
+    uint32_t a = s == INT32_MIN ? 0x7FFFFFFFu : (uint32_t)(s < 0 ? -s : s);
+    int32_t h = s >> 16;
+    if (a > acc.peak[ch]) acc.peak[ch] = a;
+    if (a >= METER_CLIP_LEVEL) acc.clips++;
+    acc.sumsq[ch] += (uint64_t)(h * h);
+}
+
+int meter_pcm(const int32_t *buf, unsigned long frames, struct meter_window *w) {
+    unsigned long i = 0;
+
+#ifdef METER_NEON
+    uint32x4_t peak_l = vdupq_n_u32(0), peak_r = vdupq_n_u32(0);
+    uint32x4_t clips  = vdupq_n_u32(0);
+    uint64x2_t sq_l   = vdupq_n_u64(0), sq_r = vdupq_n_u64(0);
+    const uint32x4_t clip_level = vdupq_n_u32(METER_CLIP_LEVEL);
+
+    for (; i + 4 <= frames; i += 4) {
+        int32x4x2_t x = vld2q_s32(buf + i * 2);         /* val[0] = L, val[1] = R */
+        uint32x4_t al = vreinterpretq_u32_s32(vqabsq_s32(x.val[0]));
+        uint32x4_t ar = vreinterpretq_u32_s32(vqabsq_s32(x.val[1]));
+        peak_l = vmaxq_u32(peak_l, al);
+        peak_r = vmaxq_u32(peak_r, ar);
+        /* compare masks are all-ones: subtracting adds 1 per clip */
+        clips  = vsubq_u32(clips, vcgeq_u32(al, clip_level));
+        clips  = vsubq_u32(clips, vcgeq_u32(ar, clip_level));
+        int16x4_t hl = vshrn_n_s32(x.val[0], 16);
+        int16x4_t hr = vshrn_n_s32(x.val[1], 16);
+        sq_l = vpadalq_u32(sq_l, vreinterpretq_u32_s32(vmull_s16(hl, hl)));
+        sq_r = vpadalq_u32(sq_r, vreinterpretq_u32_s32(vmull_s16(hr, hr)));
+    }
+
+    uint32x2_t pl = vpmax_u32(vget_low_u32(peak_l), vget_high_u32(peak_l));
+    uint32x2_t pr = vpmax_u32(vget_low_u32(peak_r), vget_high_u32(peak_r));
+    pl = vpmax_u32(pl, pl);
+    pr = vpmax_u32(pr, pr);
+    if (vget_lane_u32(pl, 0) > acc.peak[0]) acc.peak[0] = vget_lane_u32(pl, 0);
+    if (vget_lane_u32(pr, 0) > acc.peak[1]) acc.peak[1] = vget_lane_u32(pr, 0);
+    uint64x2_t c = vpaddlq_u32(clips);
+    acc.clips    += vgetq_lane_u64(c, 0) + vgetq_lane_u64(c, 1);
+    acc.sumsq[0] += vgetq_lane_u64(sq_l, 0) + vgetq_lane_u64(sq_l, 1);
+    acc.sumsq[1] += vgetq_lane_u64(sq_r, 0) + vgetq_lane_u64(sq_r, 1);
+#endif
+
+    for (; i < frames; i++) {
+        pcm_sample(0, buf[i * 2]);
+        pcm_sample(1, buf[i * 2 + 1]);
+    }
+    acc.frames += frames;
+    return window_done(w);
+}
+
+/* ── DSD ──────────────────────────────────────────────────────────── */
+
+/* `swap` is a constant in both callers: two specialised loops */
+static inline __attribute__((always_inline))
+int dsd_pass(uint32_t *buf, unsigned long frames, struct meter_window *w, const int swap) {
+    unsigned long i = 0;
+
+    if (!frames) return 0;
+    if (acc.frames == 0) {
+        acc.pattern[0] = swap ? PC_BSWAP32(buf[0]) : buf[0];
+        acc.pattern[1] = swap ? PC_BSWAP32(buf[1]) : buf[1];
+        acc.constant   = 1;
+    }
+
+#ifdef METER_NEON
+    uint32x4_t ones_l = vdupq_n_u32(0), ones_r = vdupq_n_u32(0);
+    uint32x4_t same   = vdupq_n_u32(acc.constant ? ~0u : 0);
+    const uint32x4_t pat_l = vdupq_n_u32(acc.pattern[0]);
+    const uint32x4_t pat_r = vdupq_n_u32(acc.pattern[1]);
+
+    for (; i + 4 <= frames; i += 4) {
+        uint32x4x2_t x = vld2q_u32(buf + i * 2);
+        uint8x16_t bl = vreinterpretq_u8_u32(x.val[0]);
+        uint8x16_t br = vreinterpretq_u8_u32(x.val[1]);
+        if (swap) {
+            bl = vrev32q_u8(bl);
+            br = vrev32q_u8(br);
+            x.val[0] = vreinterpretq_u32_u8(bl);
+            x.val[1] = vreinterpretq_u32_u8(br);
+            vst2q_u32(buf + i * 2, x);
+        }
+        ones_l = vpadalq_u16(ones_l, vpaddlq_u8(vcntq_u8(bl)));
+        ones_r = vpadalq_u16(ones_r, vpaddlq_u8(vcntq_u8(br)));
+        same = vandq_u32(same, vandq_u32(vceqq_u32(x.val[0], pat_l),
+                                         vceqq_u32(x.val[1], pat_r)));
+    }
+
+    uint64x2_t ol = vpaddlq_u32(ones_l), orr = vpaddlq_u32(ones_r);
+    acc.ones[0] += vgetq_lane_u64(ol, 0) + vgetq_lane_u64(ol, 1);
+    acc.ones[1] += vgetq_lane_u64(orr, 0) + vgetq_lane_u64(orr, 1);
+    uint32x2_t s2 = vand_u32(vget_low_u32(same), vget_high_u32(same));
+    acc.constant = (vget_lane_u32(s2, 0) & vget_lane_u32(s2, 1)) == ~0u;
+#endif
+
+    for (; i < frames; i++) {
+        for (int ch = 0; ch < 2; ch++) {
+            uint32_t v = buf[i * 2 + ch];
+            if (swap) buf[i * 2 + ch] = v = PC_BSWAP32(v);
+            acc.ones[ch] += __builtin_popcount(v);
+            if (v != acc.pattern[ch]) acc.constant = 0;
+        }
+    }
+    acc.frames += frames;
+    return window_done(w);
+}
+
+int meter_dsd_swap(uint32_t *buf, unsigned long frames, struct meter_window *w) {
+    return dsd_pass(buf, frames, w, 1);
+}
+
+int meter_dsd(const uint32_t *buf, unsigned long frames, struct meter_window *w) {
+    return dsd_pass((uint32_t *)buf, frames, w, 0);
+}
+
+const char *meter_state_name(enum meter_state state) {
+    switch (state) {
+    case METER_SIGNAL:   return "signal";
+    case METER_SILENCE:  return "silence";
+    case METER_DSD_IDLE: return "dsd_idle";
+    default:             return "none";
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * Level metering and signal state, computed in the audio loop's own
+ * pass over each capture period — no second read of the data.
+ *
+ *   PCM  per-channel peak, sum of squares (top 16 bits) and clip count
+ *   DSD  DSD byte swap fused with per-channel ones density and a check
+ *        for a constant idle pattern (0x69…, 0x55…: "DSD silence");
+ *        no swap when the gadget delivers DSD_U32_LE already
+ *
+ * NEON on ARMv7 (vld2 de-interleaves L/R for free), plain C elsewhere.
+ * Periods are reduced to METER_WINDOW_MS windows; only completed windows
+ * leave the audio thread, through router_stats ("ctl stats").  Nothing
+ * here uses floating point — dB are computed by the reader.
+ */
+
+#ifndef METER_H
+#define METER_H
+
+#include <stdint.h>
+
+#define METER_WINDOW_MS     100
+#define METER_SILENCE_PEAK  (1u << 8)           /* below 24-bit LSB */
+#define METER_CLIP_LEVEL    0x7FFFFF00u         /* 24-bit full scale */
+
+enum meter_state {
+    METER_NONE = 0,     /* no stream yet */
+    METER_SIGNAL,
+    METER_SILENCE,      /* PCM: digital silence */
+    METER_DSD_IDLE,     /* DSD: constant 50 % pattern */
+};
+
+struct meter_window {
+    int is_dsd;
+    enum meter_state state;
+    unsigned long frames;
+    uint32_t peak[2];           /* |sample|, full scale 2^31 */
+    uint64_t sumsq[2];          /* Σ (sample >> 16)², full scale 2^30 per frame */
+    uint32_t clips;             /* samples at or above METER_CLIP_LEVEL */
+    uint32_t ones[2];           /* DSD: 1 bits, out of frames × 32 */
+    unsigned int silent_windows;    /* consecutive windows without signal */
+};
+
+void meter_configure(unsigned int lrck_rate, int is_dsd);
+
+/* Audio thread, once per capture period.  Return 1 and fill *w when a
+ * window completes. */
+int meter_pcm(const int32_t *buf, unsigned long frames, struct meter_window *w);
+
+/* Swaps USB byte order to DSD_U32_LE in place while metering */
+int meter_dsd_swap(uint32_t *buf, unsigned long frames, struct meter_window *w);
+
+/* Already DSD_U32_LE: the gadget swapped in its copy (capture_dsd_swap) */
+int meter_dsd(const uint32_t *buf, unsigned long frames, struct meter_window *w);
+
+const char *meter_state_name(enum meter_state state);
+
+#endif /* METER_H */
@@ -0,0 +1,361 @@
+/*
+ * Local play server, router side — see play_server.h
+ *
+ * Slot lifetime is owned by the control thread, use by the audio
+ * thread.  The handover is one atomic per slot:
+ *
+ *   FREE ──attach──▶ LIVE ──reclaim──▶ RETIRE ──pick()──▶ RETIRED ──▶ FREE
+ *        (control)          (control)          (audio)        (control)
+ *
+ * The control thread only unmaps and closes a slot once the audio
+ * thread has acknowledged RETIRE from play_server_pick(), i.e. between
+ * two periods, so the audio thread never touches a ring that is gone
+ * and never needs a lock.  On the audio thread a steady stream costs
+ * one memcpy per period and no syscalls; data_efd is polled only when
+ * the on-air ring runs short.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+
+#include "play_server.h"
+
+#define PLAY_MAX_FRAMES     (1UL << 20)     /* 8 MiB per player */
+#define RETIRE_WAIT_MS      200             /* audio thread acks once per period */
+
+enum slot_state {
+    SLOT_FREE = 0,
+    SLOT_LIVE,
+    SLOT_RETIRE,            /* control thread wants it back */
+    SLOT_RETIRED,           /* audio thread let go */
+};
+
+struct play_slot {
+    _Atomic int state;              /* enum slot_state */
+
+    /* Set by the control thread before LIVE, read-only afterwards.
+     * Cached here: the player can scribble over its header copy. */
+    struct play_header *hdr;
+    uint8_t *ring;
+    uint64_t ring_frames;           /* power of two */
+    size_t map_size;
+    int memfd, data_efd, space_efd;
+    int pid;
+    unsigned int rate, priority;
+    char name[PLAY_NAME_MAX];
+
+    /* Audio thread only */
+    int on_air;
+    uint64_t empty_since_ns;        /* on-air ring ran dry, 0 = has data */
+};
+
+static struct play_slot slots[PLAY_MAX_CLIENTS];
+static unsigned int nclients;
+static unsigned long ring_frames;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void slot_release(struct play_slot *s) {
+    if (s->hdr) munmap(s->hdr, s->map_size);
+    if (s->memfd >= 0) close(s->memfd);
+    if (s->data_efd >= 0) close(s->data_efd);
+    if (s->space_efd >= 0) close(s->space_efd);
+    s->hdr = NULL;
+    s->ring = NULL;
+    s->memfd = s->data_efd = s->space_efd = -1;
+    atomic_store_explicit(&s->state, SLOT_FREE, memory_order_release);
+}
+
+int play_server_init(unsigned int clients, unsigned long frames) {
+    for (int i = 0; i < PLAY_MAX_CLIENTS; i++) {
+        slots[i].memfd = slots[i].data_efd = slots[i].space_efd = -1;
+        atomic_store(&slots[i].state, SLOT_FREE);
+    }
+    nclients = clients > PLAY_MAX_CLIENTS ? PLAY_MAX_CLIENTS : clients;
+    if (!nclients) return 0;
+
+    ring_frames = 1024;
+    while (ring_frames < frames && ring_frames < PLAY_MAX_FRAMES)
+        ring_frames <<= 1;
+
+    printf("[PLAY] %u players, %lu frames each\n", nclients, ring_frames);
+    return 0;
+}
+
+void play_server_exit(void) {
+    for (unsigned int i = 0; i < nclients; i++)
+        if (atomic_load(&slots[i].state) != SLOT_FREE)
+            slot_release(&slots[i]);
+    nclients = 0;
+}
+
+int play_server_enabled(void) {
+    return nclients > 0;
+}
+
+/* ── Control thread ───────────────────────────────────────────────── */
+
+static int pid_alive(int pid) {
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+static const char *state_name(uint32_t state) {
+    switch (state) {
+    case PLAY_IDLE:      return "idle";
+    case PLAY_STREAMING: return "streaming";
+    case PLAY_CLOSED:    return "closed";
+    default:             return "?";
+    }
+}
+
+/* Retire players that exited or closed and drained, then free every
+ * slot the audio thread has let go of */
+static void reclaim(void) {
+    int pending = 0;
+
+    for (unsigned int i = 0; i < nclients; i++) {
+        struct play_slot *s = &slots[i];
+        if (atomic_load(&s->state) != SLOT_LIVE) continue;
+
+        struct play_header *h = s->hdr;
+        int drained = atomic_load(&h->write_pos) == atomic_load(&h->read_pos);
+        if (!pid_alive(s->pid) || (atomic_load(&h->state) == PLAY_CLOSED && drained))
+            atomic_store(&s->state, SLOT_RETIRE);
+    }
+
+    for (int waited = 0; ; waited += 5) {
+        pending = 0;
+        for (unsigned int i = 0; i < nclients; i++) {
+            int st = atomic_load(&slots[i].state);
+            if (st == SLOT_RETIRED) slot_release(&slots[i]);
+            else if (st == SLOT_RETIRE) pending++;
+        }
+        if (!pending || waited >= RETIRE_WAIT_MS) break;
+        usleep(5000);
+    }
+}
+
+static int slot_setup(struct play_slot *s) {
+    s->ring_frames = ring_frames;
+    s->map_size = PLAY_HEADER_SIZE + ring_frames * PLAY_FRAME_BYTES;
+
+    s->memfd = memfd_create("uac2_router.play", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (s->memfd < 0) return -errno;
+    if (ftruncate(s->memfd, s->map_size) < 0) return -errno;
+    /* The player maps it too — forbid resizing under our feet */
+    fcntl(s->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+
+    void *map = mmap(NULL, s->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, s->memfd, 0);
+    if (map == MAP_FAILED) return -errno;
+    s->hdr  = map;
+    s->ring = (uint8_t *)map + PLAY_HEADER_SIZE;
+
+    s->data_efd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    s->space_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s->data_efd < 0 || s->space_efd < 0) return -errno;
+    return 0;
+}
+
+int play_server_attach(int pid, unsigned int rate, unsigned int priority,
+                       const char *name, int fds[3]) {
+    if (!nclients) return -1;
+
+    reclaim();
+
+    for (unsigned int i = 0; i < nclients; i++) {
+        struct play_slot *s = &slots[i];
+        if (atomic_load(&s->state) != SLOT_FREE) continue;
+
+        int err = slot_setup(s);
+        if (err < 0) {
+            fprintf(stderr, "[PLAY] Cannot set up slot %u: %s\n", i, strerror(-err));
+            slot_release(s);
+            return -1;
+        }
+
+        /* Names end up in stats lines: keep them to one token */
+        size_t n = 0;
+        for (; name && name[n] && n < PLAY_NAME_MAX - 1; n++) {
+            char c = name[n];
+            int ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                     (c >= '0' && c <= '9') || c == '-' || c == '_';
+            s->name[n] = ok ? c : '_';
+        }
+        if (!n) n = snprintf(s->name, sizeof(s->name), "pid%d", pid);
+        s->name[n] = '\0';
+
+        s->pid           = pid;
+        s->rate          = rate;
+        s->priority      = priority;
+
+        struct play_header *h = s->hdr;
+        h->magic       = PLAY_MAGIC;
+        h->version     = PLAY_VERSION;
+        h->header_size = PLAY_HEADER_SIZE;
+        h->frame_bytes = PLAY_FRAME_BYTES;
+        h->ring_frames = ring_frames;
+        h->rate        = rate;
+        h->priority    = priority;
+        memcpy(h->name, s->name, sizeof(h->name));
+        atomic_store(&h->state, PLAY_IDLE);
+
+        fds[0] = s->memfd;
+        fds[1] = s->data_efd;
+        fds[2] = s->space_efd;
+        atomic_store_explicit(&s->state, SLOT_LIVE, memory_order_release);
+
+        printf("[PLAY] slot %u: %s (pid %d) %u Hz, priority %u\n",
+               i, s->name, pid, rate, priority);
+        return i;
+    }
+    return -1;
+}
+
+int play_server_stats(char *out, size_t size) {
+    int len = 0;
+
+    if (!nclients || size == 0) return 0;
+
+    len += snprintf(out + len, size - len, "play_clients=%u\nplay_frames=%lu\n",
+                    nclients, ring_frames);
+    for (unsigned int i = 0; i < nclients && len < (int)size; i++) {
+        struct play_slot *s = &slots[i];
+        int st = atomic_load(&s->state);
+        if (st != SLOT_LIVE && st != SLOT_RETIRE) continue;
+        struct play_header *h = s->hdr;
+        len += snprintf(out + len, size - len,
+                        "play%u=%s pid:%d rate:%u prio:%u state:%s fill:%llu underruns:%llu%s\n",
+                        i, s->name, s->pid, s->rate, s->priority, state_name(atomic_load(&h->state)),
+                        (unsigned long long)(atomic_load(&h->write_pos) - atomic_load(&h->read_pos)),
+                        (unsigned long long)atomic_load(&h->underruns),
+                        atomic_load(&h->on_air) ? " on_air" : "");
+    }
+    return len < (int)size ? len : (int)size - 1;
+}
+
+/* ── Audio thread ─────────────────────────────────────────────────── */
+
+static int slot_ready(struct play_slot *s, uint64_t *now) {
+    struct play_header *h = s->hdr;
+
+    if (atomic_load_explicit(&h->write_pos, memory_order_acquire) !=
+        atomic_load_explicit(&h->read_pos, memory_order_relaxed))
+        return 1;
+    if (atomic_load_explicit(&h->state, memory_order_relaxed) != PLAY_STREAMING)
+        return 0;
+    if (!s->empty_since_ns)
+        return 1;
+    if (!*now) *now = now_ns();
+    return *now - s->empty_since_ns < PLAY_STALL_MS * 1000000ULL;
+}
+
+int play_server_pick(unsigned int *rate, unsigned int *priority) {
+    struct play_slot *best = NULL;
+    uint64_t now = 0;
+    int best_slot = -1;
+
+    for (unsigned int i = 0; i < nclients; i++) {
+        struct play_slot *s = &slots[i];
+        int st = atomic_load_explicit(&s->state, memory_order_acquire);
+
+        if (st == SLOT_RETIRE) {
+            s->on_air = 0;
+            s->empty_since_ns = 0;
+            atomic_store_explicit(&s->state, SLOT_RETIRED, memory_order_release);
+            continue;
+        }
+        if (st != SLOT_LIVE || !slot_ready(s, &now))
+            continue;
+        if (!best || s->priority > best->priority ||
+            (s->priority == best->priority && s->on_air)) {
+            best = s;
+            best_slot = i;
+        }
+    }
+    if (best) {
+        *rate     = best->rate;
+        *priority = best->priority;
+    }
+    return best_slot;
+}
+
+long play_server_read(int slot, void *dst, unsigned long frames, int timeout_ms) {
+    struct play_slot *s = &slots[slot];
+    struct play_header *h = s->hdr;
+    static const uint64_t one = 1;
+
+    if (atomic_load_explicit(&s->state, memory_order_acquire) != SLOT_LIVE)
+        return -1;
+
+    const uint64_t size = s->ring_frames;
+    uint64_t r = atomic_load_explicit(&h->read_pos, memory_order_relaxed);
+    uint64_t w = atomic_load_explicit(&h->write_pos, memory_order_acquire);
+
+    if (w - r < frames &&
+        atomic_load_explicit(&h->state, memory_order_relaxed) == PLAY_STREAMING) {
+        /* Short: sleep until the player writes, at most timeout_ms */
+        atomic_store(&h->router_waiting, 1);
+        w = atomic_load(&h->write_pos);
+        if (w - r < frames) {
+            struct pollfd pfd = { .fd = s->data_efd, .events = POLLIN };
+            uint64_t drain;
+            if (poll(&pfd, 1, timeout_ms) > 0)
+                while (read(s->data_efd, &drain, sizeof(drain)) > 0)
+                    ;
+        }
+        atomic_store(&h->router_waiting, 0);
+        w = atomic_load_explicit(&h->write_pos, memory_order_acquire);
+    }
+
+    uint64_t n = w - r;
+    if (n > size) {                     /* player broke the protocol: resync */
+        atomic_store_explicit(&h->read_pos, w, memory_order_release);
+        return 0;
+    }
+    if (n > frames) n = frames;
+    if (n == 0) {
+        if (!s->empty_since_ns) s->empty_since_ns = now_ns();
+        if (s->on_air) atomic_fetch_add_explicit(&h->underruns, 1, memory_order_relaxed);
+        return 0;
+    }
+    s->empty_since_ns = 0;
+
+    uint64_t off = r & (size - 1);
+    uint64_t first = (off + n > size) ? size - off : n;
+    memcpy(dst, s->ring + off * PLAY_FRAME_BYTES, first * PLAY_FRAME_BYTES);
+    if (n > first)
+        memcpy((uint8_t *)dst + first * PLAY_FRAME_BYTES, s->ring,
+               (n - first) * PLAY_FRAME_BYTES);
+    /* seq_cst pairs with the player's waiting flag: no lost wakeup */
+    atomic_store(&h->read_pos, r + n);
+    if (atomic_exchange(&h->player_waiting, 0))
+        if (write(s->space_efd, &one, sizeof(one)) < 0) { /* EAGAIN: counter full */ }
+    return (long)n;
+}
+
+void play_server_on_air(int slot, int on) {
+    struct play_slot *s = &slots[slot];
+    if (atomic_load_explicit(&s->state, memory_order_acquire) != SLOT_LIVE)
+        return;                         /* retired by pick() already */
+    s->on_air = on;
+    s->empty_since_ns = 0;
+    atomic_store_explicit(&s->hdr->on_air, on, memory_order_relaxed);
+}
+
+const char *play_server_name(int slot) {
+    return slots[slot].name;
+}
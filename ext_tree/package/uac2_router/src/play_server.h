@@ -0,0 +1,132 @@
+/*
+ * Local play server — on-device players share the router's outputs
+ *
+ * The router is the only process that opens the I2S card (and the
+ * USB-host DAC, sink.h).  USB capture is one source; local players
+ * (librespot, shairport-sync, … through uac2_play) are the others.
+ * Every player gets its own memfd ring: a header page followed by
+ * frames in the USB wire format — 2 ch × 32 bit, S32_LE for PCM, DSD in
+ * USB RAW byte order (oldest bit in the lowest byte) — so both kinds of
+ * source take the same swap / meter / bus path.  The player is the only
+ * writer of write_pos and state, the router of read_pos and on_air.
+ *
+ * Attaching: send "play <rate> [priority] [name]" on the control socket
+ * (rate as on USB: Hz, DSD bit rate for DSD).  The reply
+ * "play slot=<n>" carries three fds via SCM_RIGHTS: the
+ * memfd (sealed against resizing), data_efd (player → router: frames
+ * were written) and space_efd (router → player: frames were consumed).
+ * Each side only signals when the other has set its *_waiting flag, so
+ * a steady stream costs no eventfd traffic at all.  A new rate means a
+ * new attach; slots of exited players are reclaimed on the next attach.
+ *
+ * Arbitration (uac2_router.c, once per period): the ready source with
+ * the highest priority is on air.  A player is ready while its ring
+ * holds frames, or while it is PLAY_STREAMING and has not starved for
+ * PLAY_STALL_MS.  USB has USB_PRIORITY and wins ties; between players
+ * the one on air keeps it.  A switch between sources at the same rate
+ * and PCM/DSD mode keeps every sink open.
+ *
+ * Detaching: set state to PLAY_CLOSED.  Frames still in the ring are
+ * played out first.
+ *
+ * This header is shared with out-of-tree players — keep it free of
+ * router internals and bump PLAY_VERSION on layout changes.
+ */
+
+#ifndef PLAY_SERVER_H
+#define PLAY_SERVER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+
+#define PLAY_MAGIC          0x59414c50u     /* "PLAY" */
+#define PLAY_VERSION        1
+#define PLAY_HEADER_SIZE    4096            /* data ring starts here */
+#define PLAY_FRAME_BYTES    8               /* 2 ch × 32 bit */
+#define PLAY_MAX_CLIENTS    4
+#define PLAY_NAME_MAX       16
+#define PLAY_PRIORITY_MAX   255
+#define PLAY_STALL_MS       1000
+
+enum play_state {
+    PLAY_IDLE = 0,          /* attached, nothing to play (paused) */
+    PLAY_STREAMING,         /* writing; keeps the source ready across short gaps */
+    PLAY_CLOSED,            /* done: drain, then the slot is reclaimed */
+};
+
+struct play_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t frame_bytes;
+    uint64_t ring_frames;           /* power of two */
+    uint32_t rate;                  /* as attached, DSD bit rate for DSD */
+    uint32_t priority;
+    char name[PLAY_NAME_MAX];
+
+    /* Player side */
+    _Atomic uint64_t write_pos;     /* frames ever written */
+    _Atomic uint32_t state;         /* enum play_state */
+    _Atomic uint32_t player_waiting;    /* player sleeps on space_efd */
+    uint8_t pad0[48];
+
+    /* Router side */
+    _Atomic uint64_t read_pos;      /* frames ever consumed */
+    _Atomic uint32_t router_waiting;    /* router sleeps on data_efd */
+    _Atomic uint32_t on_air;        /* 1 while this player feeds the sinks */
+    _Atomic uint64_t underruns;     /* on-air periods the ring ran dry */
+};
+
+/*
+ * Copy up to `frames` frames into the ring without blocking.  Returns
+ * frames copied; 0 means the ring is full — set player_waiting, check
+ * again, then sleep on space_efd.
+ */
+static inline unsigned long play_write(struct play_header *hdr, uint8_t *ring, int data_efd,
+                                       const void *src, unsigned long frames)
+{
+    static const uint64_t one = 1;
+    const uint64_t size = hdr->ring_frames;
+
+    uint64_t w = atomic_load_explicit(&hdr->write_pos, memory_order_relaxed);
+    uint64_t r = atomic_load_explicit(&hdr->read_pos, memory_order_acquire);
+    uint64_t n = size - (w - r);
+    if (n > frames) n = frames;
+    if (n == 0) return 0;
+
+    uint64_t off = w & (size - 1);
+    uint64_t first = (off + n > size) ? size - off : n;
+    memcpy(ring + off * PLAY_FRAME_BYTES, src, first * PLAY_FRAME_BYTES);
+    if (n > first)
+        memcpy(ring, (const uint8_t *)src + first * PLAY_FRAME_BYTES,
+               (n - first) * PLAY_FRAME_BYTES);
+    /* seq_cst pairs with the router's waiting flag: no lost wakeup */
+    atomic_store(&hdr->write_pos, w + n);
+    if (atomic_exchange(&hdr->router_waiting, 0))
+        if (write(data_efd, &one, sizeof(one)) < 0) { /* EAGAIN: already signalled */ }
+    return (unsigned long)n;
+}
+
+/* ── Router side ──────────────────────────────────────────────────── */
+
+int  play_server_init(unsigned int clients, unsigned long ring_frames);  /* 0 clients = off */
+void play_server_exit(void);
+int  play_server_enabled(void);
+
+/* Control thread: new player, returns slot and the three fds to pass */
+int  play_server_attach(int pid, unsigned int rate, unsigned int priority,
+                        const char *name, int fds[3]);
+int  play_server_stats(char *out, size_t size);
+
+/* Audio thread, lock-free.  pick() returns the best ready slot (-1 if
+ * none) and retires slots the control thread gave up; a slot it did not
+ * return must not be read afterwards. */
+int  play_server_pick(unsigned int *rate, unsigned int *priority);
+long play_server_read(int slot, void *dst, unsigned long frames, int timeout_ms);
+void play_server_on_air(int slot, int on);
+const char *play_server_name(int slot);
+
+#endif /* PLAY_SERVER_H */
@@ -0,0 +1,651 @@
+/*
+ * Diagnostic stream recorder — see recorder.h
+ *
+ * Block flow (indices of a fixed pool, two single-producer rings):
+ *
+ *   free ring ──► audio thread fills block ──► ready ring ──► writer
+ *       ▲                                                       │
+ *       └──────────── io_uring completion (WRITE_FIXED) ◄───────┘
+ *
+ * The writer sleeps on one eventfd that is signalled both by the audio
+ * thread (block ready) and by io_uring (registered completion eventfd).
+ * Submissions are made from the writer, so io_uring's worker threads
+ * inherit SCHED_OTHER, never the audio thread's RT policy.
+ *
+ * Stop handshake: the control side clears rec_mask, then waits for
+ * rt_busy == 0 (both seq_cst, Dekker style) — after that the audio
+ * thread can't touch the pool and its partial blocks can be flushed.
+ *
+ * The toolchain headers predate io_uring (4.20), so the few uapi
+ * definitions needed are carried here, like dl_sched_attr in rt_sched.c.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#include "recorder.h"
+
+#define REC_BLOCK_SIZE      (64 * 1024)
+#define REC_MIN_BLOCKS      4
+#define REC_MAX_BLOCKS      1024            /* 64 MiB */
+#define REC_EVENTS          8               /* pending format changes */
+
+/* ── io_uring uapi subset (linux/io_uring.h, 5.1+) ───────────────── */
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup     425
+#define __NR_io_uring_enter     426
+#define __NR_io_uring_register  427
+#endif
+
+#define URING_OFF_SQ_RING       0ULL
+#define URING_OFF_CQ_RING       0x8000000ULL
+#define URING_OFF_SQES          0x10000000ULL
+#define URING_FEAT_SINGLE_MMAP  (1U << 0)
+#define URING_OP_WRITE_FIXED    5
+#define URING_REGISTER_BUFFERS  0
+#define URING_REGISTER_EVENTFD  4
+
+struct uring_sqe {
+    uint8_t  opcode;
+    uint8_t  flags;
+    uint16_t ioprio;
+    int32_t  fd;
+    uint64_t off;
+    uint64_t addr;
+    uint32_t len;
+    uint32_t rw_flags;
+    uint64_t user_data;
+    uint16_t buf_index;
+    uint16_t personality;
+    int32_t  splice_fd_in;
+    uint64_t pad[2];
+};
+
+struct uring_cqe {
+    uint64_t user_data;
+    int32_t  res;
+    uint32_t flags;
+};
+
+struct uring_sqring_offsets {
+    uint32_t head, tail, ring_mask, ring_entries, flags, dropped, array, resv1;
+    uint64_t resv2;
+};
+
+struct uring_cqring_offsets {
+    uint32_t head, tail, ring_mask, ring_entries, overflow, cqes, flags, resv1;
+    uint64_t resv2;
+};
+
+struct uring_params {
+    uint32_t sq_entries, cq_entries, flags, sq_thread_cpu, sq_thread_idle;
+    uint32_t features, wq_fd, resv[3];
+    struct uring_sqring_offsets sq_off;
+    struct uring_cqring_offsets cq_off;
+};
+
+struct uring {
+    int fd;
+    void *sq_map, *cq_map;
+    size_t sq_map_size, cq_map_size;
+    struct uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int *sq_tail, *sq_mask, *sq_array;
+    unsigned int *cq_head, *cq_tail, *cq_mask;
+    struct uring_cqe *cqes;
+};
+
+static int uring_init(struct uring *u, unsigned int entries) {
+    struct uring_params p;
+
+    memset(&p, 0, sizeof(p));
+    memset(u, 0, sizeof(*u));
+    u->fd = syscall(__NR_io_uring_setup, entries, &p);
+    if (u->fd < 0) return -errno;
+
+    u->sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    u->cq_map_size = p.cq_off.cqes + p.cq_entries * sizeof(struct uring_cqe);
+    if (p.features & URING_FEAT_SINGLE_MMAP) {
+        if (u->cq_map_size > u->sq_map_size) u->sq_map_size = u->cq_map_size;
+        u->cq_map_size = 0;
+    }
+
+    u->sq_map = mmap(NULL, u->sq_map_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, u->fd, URING_OFF_SQ_RING);
+    if (u->sq_map == MAP_FAILED) goto fail;
+    if (u->cq_map_size) {
+        u->cq_map = mmap(NULL, u->cq_map_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, u->fd, URING_OFF_CQ_RING);
+        if (u->cq_map == MAP_FAILED) goto fail;
+    } else {
+        u->cq_map = u->sq_map;
+    }
+    u->sqes_size = p.sq_entries * sizeof(struct uring_sqe);
+    u->sqes = mmap(NULL, u->sqes_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, u->fd, URING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) goto fail;
+
+    u->sq_tail  = (unsigned int *)((char *)u->sq_map + p.sq_off.tail);
+    u->sq_mask  = (unsigned int *)((char *)u->sq_map + p.sq_off.ring_mask);
+    u->sq_array = (unsigned int *)((char *)u->sq_map + p.sq_off.array);
+    u->cq_head  = (unsigned int *)((char *)u->cq_map + p.cq_off.head);
+    u->cq_tail  = (unsigned int *)((char *)u->cq_map + p.cq_off.tail);
+    u->cq_mask  = (unsigned int *)((char *)u->cq_map + p.cq_off.ring_mask);
+    u->cqes     = (struct uring_cqe *)((char *)u->cq_map + p.cq_off.cqes);
+    return 0;
+
+fail:
+    {
+        int err = -errno;
+        if (u->sqes && u->sqes != MAP_FAILED) munmap(u->sqes, u->sqes_size);
+        if (u->cq_map_size && u->cq_map && u->cq_map != MAP_FAILED)
+            munmap(u->cq_map, u->cq_map_size);
+        if (u->sq_map && u->sq_map != MAP_FAILED) munmap(u->sq_map, u->sq_map_size);
+        close(u->fd);
+        u->fd = -1;
+        return err;
+    }
+}
+
+static void uring_exit(struct uring *u) {
+    if (u->fd < 0) return;
+    munmap(u->sqes, u->sqes_size);
+    if (u->cq_map_size) munmap(u->cq_map, u->cq_map_size);
+    munmap(u->sq_map, u->sq_map_size);
+    close(u->fd);
+    u->fd = -1;
+}
+
+static void uring_queue_write_fixed(struct uring *u, int fd, const void *buf,
+                                    unsigned int len, uint64_t off, uint64_t user_data) {
+    unsigned int tail = *u->sq_tail;
+    unsigned int idx = tail & *u->sq_mask;
+    struct uring_sqe *sqe = &u->sqes[idx];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = URING_OP_WRITE_FIXED;
+    sqe->fd        = fd;
+    sqe->off       = off;
+    sqe->addr      = (uintptr_t)buf;
+    sqe->len       = len;
+    sqe->user_data = user_data;
+    sqe->buf_index = 0;             /* whole pool is one registered buffer */
+    u->sq_array[idx] = idx;
+    __atomic_store_n(u->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* ── Block pool and SPSC index rings ─────────────────────────────── */
+
+struct rec_block {
+    uint8_t *data;
+    uint32_t len;
+    uint8_t stream;                 /* 0 pre, 1 post */
+};
+
+struct idx_ring {
+    _Atomic unsigned int head;      /* consumer */
+    _Atomic unsigned int tail;      /* producer */
+    unsigned int mask;
+    uint16_t *slot;
+};
+
+static int ring_push(struct idx_ring *r, unsigned int v) {
+    unsigned int t = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    if (t - atomic_load_explicit(&r->head, memory_order_acquire) > r->mask) return -1;
+    r->slot[t & r->mask] = v;
+    atomic_store_explicit(&r->tail, t + 1, memory_order_release);
+    return 0;
+}
+
+static int ring_pop(struct idx_ring *r) {
+    unsigned int h = atomic_load_explicit(&r->head, memory_order_relaxed);
+    if (h == atomic_load_explicit(&r->tail, memory_order_acquire)) return -1;
+    int v = r->slot[h & r->mask];
+    atomic_store_explicit(&r->head, h + 1, memory_order_release);
+    return v;
+}
+
+static unsigned int ring_count(struct idx_ring *r) {
+    return atomic_load(&r->tail) - atomic_load(&r->head);
+}
+
+struct rec_event {
+    unsigned int rate, lrck_rate;
+    int is_dsd;
+    unsigned long long offset[2];
+};
+
+/* ── State ────────────────────────────────────────────────────────── */
+
+/* Defaults from router_conf */
+static unsigned int def_streams;
+static char def_dir[64] = "/data";
+static unsigned int def_buf_kb = 4096;
+
+/* Shared with the audio thread */
+static _Atomic unsigned int rec_mask;
+static _Atomic int rt_busy;
+static struct idx_ring free_ring, ready_ring;
+static struct rec_event events[REC_EVENTS];
+static _Atomic unsigned int ev_head, ev_tail;
+static int wake_fd = -1;
+static _Atomic unsigned long long accepted[2], dropped[2];
+static _Atomic unsigned long drop_events[2];
+static _Atomic unsigned int cur_rate, cur_lrck, cur_dsd;
+
+/* Audio thread only */
+static int cur_block[2] = { -1, -1 };
+static int dropping[2];
+
+/* Writer / control side */
+static struct rec_block *blocks;
+static uint8_t *pool;
+static size_t pool_size;
+static unsigned int nblocks;
+static struct uring ring = { .fd = -1 };
+static int out_fd[2] = { -1, -1 };
+static FILE *info;
+static char base_path[128];
+static pthread_t writer;
+static _Atomic int finishing;
+static _Atomic unsigned long long written[2];
+static _Atomic unsigned long write_errors;
+static int last_error;
+
+/* ── Audio thread ─────────────────────────────────────────────────── */
+
+static void wake_writer(void) {
+    static const uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) { /* counter full: writer is awake anyway */ }
+}
+
+void recorder_set_format(unsigned int rate, unsigned int lrck_rate, int is_dsd) {
+    atomic_store_explicit(&cur_rate, rate, memory_order_relaxed);
+    atomic_store_explicit(&cur_lrck, lrck_rate, memory_order_relaxed);
+    atomic_store_explicit(&cur_dsd, is_dsd, memory_order_relaxed);
+
+    if (!atomic_load_explicit(&rec_mask, memory_order_relaxed)) return;
+    atomic_store(&rt_busy, 1);
+    if (atomic_load(&rec_mask)) {
+        unsigned int t = atomic_load_explicit(&ev_tail, memory_order_relaxed);
+        if (t - atomic_load_explicit(&ev_head, memory_order_acquire) < REC_EVENTS) {
+            struct rec_event *e = &events[t % REC_EVENTS];
+            e->rate      = rate;
+            e->lrck_rate = lrck_rate;
+            e->is_dsd    = is_dsd;
+            e->offset[0] = atomic_load_explicit(&accepted[0], memory_order_relaxed);
+            e->offset[1] = atomic_load_explicit(&accepted[1], memory_order_relaxed);
+            atomic_store_explicit(&ev_tail, t + 1, memory_order_release);
+            wake_writer();
+        }
+    }
+    atomic_store_explicit(&rt_busy, 0, memory_order_release);
+}
+
+void recorder_push(unsigned int stream, const void *data, size_t bytes) {
+    const uint8_t *p = data;
+    int s = (stream == RECORDER_PRE) ? 0 : 1;
+    int wake = 0;
+
+    if (!(atomic_load_explicit(&rec_mask, memory_order_relaxed) & stream)) return;
+    atomic_store(&rt_busy, 1);
+    if (!(atomic_load(&rec_mask) & stream)) goto out;
+
+    while (bytes) {
+        if (cur_block[s] < 0 && (cur_block[s] = ring_pop(&free_ring)) < 0) {
+            /* Pool exhausted — flash can't keep up, drop and count */
+            atomic_fetch_add_explicit(&dropped[s], bytes, memory_order_relaxed);
+            if (!dropping[s]) {
+                dropping[s] = 1;
+                atomic_fetch_add_explicit(&drop_events[s], 1, memory_order_relaxed);
+            }
+            break;
+        }
+        dropping[s] = 0;
+
+        struct rec_block *b = &blocks[cur_block[s]];
+        size_t n = REC_BLOCK_SIZE - b->len;
+        if (n > bytes) n = bytes;
+        memcpy(b->data + b->len, p, n);
+        b->len += n;
+        p += n;
+        bytes -= n;
+        atomic_fetch_add_explicit(&accepted[s], n, memory_order_relaxed);
+
+        if (b->len == REC_BLOCK_SIZE) {
+            b->stream = s;
+            ring_push(&ready_ring, cur_block[s]);   /* can't overflow: sized for the pool */
+            cur_block[s] = -1;
+            wake = 1;
+        }
+    }
+    if (wake) wake_writer();
+out:
+    atomic_store_explicit(&rt_busy, 0, memory_order_release);
+}
+
+/* ── Writer thread ────────────────────────────────────────────────── */
+
+static const char *const stream_names[2] = { "pre", "post" };
+
+static const char *streams_name(unsigned int mask) {
+    if (mask == (RECORDER_PRE | RECORDER_POST)) return "both";
+    return (mask & RECORDER_PRE) ? "pre" : "post";
+}
+
+static void write_events(void) {
+    unsigned int h = atomic_load_explicit(&ev_head, memory_order_relaxed);
+    while (h != atomic_load_explicit(&ev_tail, memory_order_acquire)) {
+        struct rec_event *e = &events[h % REC_EVENTS];
+        fprintf(info, "format pre@%llu post@%llu: %s %u Hz, %u frames/s\n",
+                e->offset[0], e->offset[1], e->is_dsd ? "DSD_U32_LE" : "S32_LE",
+                e->rate, e->lrck_rate);
+        atomic_store_explicit(&ev_head, ++h, memory_order_release);
+    }
+    fflush(info);
+}
+
+static void *writer_fn(void *arg) {
+    unsigned long long file_off[2] = { 0, 0 };
+    unsigned int inflight = 0;
+    struct pollfd pfd = { .fd = wake_fd, .events = POLLIN };
+    uint64_t cnt;
+
+    for (;;) {
+        if (poll(&pfd, 1, -1) < 0 && errno != EINTR)
+            break;
+        if (read(wake_fd, &cnt, sizeof(cnt)) < 0 && errno != EAGAIN)
+            break;
+
+        write_events();
+
+        /* Queue every ready block; the ring has room for the whole pool */
+        unsigned int queued = 0;
+        int i;
+        while ((i = ring_pop(&ready_ring)) >= 0) {
+            struct rec_block *b = &blocks[i];
+            uring_queue_write_fixed(&ring, out_fd[b->stream], b->data, b->len,
+                                    file_off[b->stream], i);
+            file_off[b->stream] += b->len;
+            queued++;
+        }
+        if (queued) {
+            long n = syscall(__NR_io_uring_enter, ring.fd, queued, 0, 0, NULL, 0);
+            if (n < 0) {
+                last_error = errno;
+                atomic_fetch_add(&write_errors, 1);
+                n = 0;
+            }
+            inflight += n;
+            /* The kernel never took the rest: unqueue them, last first,
+             * count them as dropped and give the blocks back */
+            for (; queued > (unsigned int)n; queued--) {
+                unsigned int tail = *ring.sq_tail - 1;
+                struct uring_sqe *sqe = &ring.sqes[ring.sq_array[tail & *ring.sq_mask]];
+                struct rec_block *b = &blocks[sqe->user_data];
+                file_off[b->stream] -= b->len;
+                atomic_fetch_add(&dropped[b->stream], b->len);
+                b->len = 0;
+                ring_push(&free_ring, sqe->user_data);
+                __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+            }
+        }
+
+        /* Reap completions, recycle blocks */
+        unsigned int head = *ring.cq_head;
+        unsigned int tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; head++) {
+            struct uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            struct rec_block *b = &blocks[cqe->user_data];
+            if (cqe->res < 0 || (uint32_t)cqe->res != b->len) {
+                last_error = cqe->res < 0 ? -cqe->res : ENOSPC;
+                atomic_fetch_add(&write_errors, 1);
+            }
+            if (cqe->res > 0)
+                atomic_fetch_add(&written[b->stream], cqe->res);
+            b->len = 0;
+            ring_push(&free_ring, cqe->user_data);
+            inflight--;
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+
+        if (atomic_load(&finishing) && inflight == 0 && ring_count(&ready_ring) == 0) {
+            write_events();
+            break;
+        }
+    }
+    return NULL;
+}
+
+/* ── Control side ─────────────────────────────────────────────────── */
+
+int recorder_parse_streams(const char *name) {
+    if (strcmp(name, "pre") == 0)  return RECORDER_PRE;
+    if (strcmp(name, "post") == 0) return RECORDER_POST;
+    if (strcmp(name, "both") == 0) return RECORDER_PRE | RECORDER_POST;
+    return -1;
+}
+
+static void release_resources(void) {
+    uring_exit(&ring);
+    for (int s = 0; s < 2; s++) {
+        if (out_fd[s] >= 0) close(out_fd[s]);
+        out_fd[s] = -1;
+    }
+    if (info) fclose(info);
+    info = NULL;
+    if (wake_fd >= 0) close(wake_fd);
+    wake_fd = -1;
+    free(free_ring.slot);
+    free(ready_ring.slot);
+    free_ring.slot = ready_ring.slot = NULL;
+    free(blocks);
+    blocks = NULL;
+    if (pool) munmap(pool, pool_size);
+    pool = NULL;
+}
+
+int recorder_start(unsigned int streams, const char *dir) {
+    char stamp[32];
+    int err;
+
+    if (atomic_load(&rec_mask)) return -EBUSY;
+    if (!streams) streams = def_streams ? def_streams : RECORDER_PRE | RECORDER_POST;
+    if (!dir || !dir[0]) dir = def_dir;
+
+    /* Pool: power of two blocks so the index rings can mask */
+    nblocks = REC_MIN_BLOCKS;
+    while (nblocks < def_buf_kb / (REC_BLOCK_SIZE / 1024) && nblocks < REC_MAX_BLOCKS)
+        nblocks <<= 1;
+    pool_size = (size_t)nblocks * REC_BLOCK_SIZE;
+    pool = mmap(NULL, pool_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (pool == MAP_FAILED) {
+        pool = NULL;
+        return -ENOMEM;
+    }
+    blocks = calloc(nblocks, sizeof(*blocks));
+    free_ring.slot  = calloc(nblocks, sizeof(uint16_t));
+    ready_ring.slot = calloc(nblocks, sizeof(uint16_t));
+    if (!blocks || !free_ring.slot || !ready_ring.slot) {
+        release_resources();
+        return -ENOMEM;
+    }
+    free_ring.mask = ready_ring.mask = nblocks - 1;
+    atomic_store(&free_ring.head, 0);
+    atomic_store(&free_ring.tail, 0);
+    atomic_store(&ready_ring.head, 0);
+    atomic_store(&ready_ring.tail, 0);
+    for (unsigned int i = 0; i < nblocks; i++) {
+        blocks[i].data = pool + (size_t)i * REC_BLOCK_SIZE;
+        blocks[i].len = 0;
+        ring_push(&free_ring, i);
+    }
+
+    /* Non-blocking: the audio thread signals it too */
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+        err = -errno;
+        release_resources();
+        return err;
+    }
+
+    if ((err = uring_init(&ring, nblocks)) < 0) {
+        fprintf(stderr, "[REC] io_uring unavailable: %s\n", strerror(-err));
+        release_resources();
+        return err;
+    }
+    struct iovec iov = { .iov_base = pool, .iov_len = pool_size };
+    if (syscall(__NR_io_uring_register, ring.fd, URING_REGISTER_BUFFERS, &iov, 1) < 0 ||
+        syscall(__NR_io_uring_register, ring.fd, URING_REGISTER_EVENTFD, &wake_fd, 1) < 0) {
+        err = -errno;
+        fprintf(stderr, "[REC] io_uring register: %s\n", strerror(-err));
+        release_resources();
+        return err;
+    }
+
+    /* Files */
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(base_path, sizeof(base_path), "%s/uac2_rec_%s", dir, stamp);
+    for (int s = 0; s < 2; s++) {
+        char path[160];
+        if (!(streams & (1u << s))) continue;
+        snprintf(path, sizeof(path), "%s_%s.raw", base_path, stream_names[s]);
+        out_fd[s] = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (out_fd[s] < 0) {
+            err = -errno;
+            fprintf(stderr, "[REC] Cannot create %s: %s\n", path, strerror(errno));
+            release_resources();
+            return err;
+        }
+    }
+    {
+        char path[160];
+        snprintf(path, sizeof(path), "%s.txt", base_path);
+        info = fopen(path, "w");
+        if (!info) {
+            err = -errno;
+            release_resources();
+            return err;
+        }
+    }
+    fprintf(info, "uac2_router recording %s\nstreams:%s%s\n"
+                  "frame: 8 bytes (2 ch x 32 bit LE; pre = USB order, post = I2S order)\n",
+            stamp, (streams & RECORDER_PRE) ? " pre" : "", (streams & RECORDER_POST) ? " post" : "");
+    fprintf(info, "format pre@0 post@0: %s %u Hz, %u frames/s\n",
+            atomic_load(&cur_dsd) ? "DSD_U32_LE" : "S32_LE",
+            atomic_load(&cur_rate), atomic_load(&cur_lrck));
+    fflush(info);
+
+    for (int s = 0; s < 2; s++) {
+        atomic_store(&accepted[s], 0);
+        atomic_store(&dropped[s], 0);
+        atomic_store(&drop_events[s], 0);
+        atomic_store(&written[s], 0);
+        cur_block[s] = -1;
+        dropping[s] = 0;
+    }
+    atomic_store(&write_errors, 0);
+    atomic_store(&ev_head, 0);
+    atomic_store(&ev_tail, 0);
+    atomic_store(&finishing, 0);
+    last_error = 0;
+
+    /* Writer never inherits the audio thread's RT policy */
+    pthread_attr_t attr;
+    struct sched_param sp = { .sched_priority = 0 };
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &sp);
+    err = pthread_create(&writer, &attr, writer_fn, NULL);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        release_resources();
+        return -err;
+    }
+
+    atomic_store(&rec_mask, streams);
+    printf("[REC] Recording %s to %s_*.raw (%u KiB pool)\n",
+           streams_name(streams), base_path, (unsigned int)(pool_size / 1024));
+    return 0;
+}
+
+int recorder_stop(void) {
+    if (!atomic_load(&rec_mask)) return -ENOENT;
+
+    /* Fence the audio thread out of the pool */
+    atomic_store(&rec_mask, 0);
+    while (atomic_load(&rt_busy))
+        usleep(100);
+
+    /* Partial blocks go out too */
+    for (int s = 0; s < 2; s++) {
+        int i = cur_block[s];
+        cur_block[s] = -1;
+        if (i < 0) continue;
+        if (blocks[i].len) {
+            blocks[i].stream = s;
+            ring_push(&ready_ring, i);
+        } else {
+            ring_push(&free_ring, i);
+        }
+    }
+    atomic_store(&finishing, 1);
+    wake_writer();
+    pthread_join(writer, NULL);
+
+    fprintf(info, "end: pre=%llu post=%llu bytes written\n"
+                  "dropped: pre=%llu bytes (%lu gaps) post=%llu bytes (%lu gaps)\n"
+                  "write errors: %lu%s%s\n",
+            atomic_load(&written[0]), atomic_load(&written[1]),
+            atomic_load(&dropped[0]), atomic_load(&drop_events[0]),
+            atomic_load(&dropped[1]), atomic_load(&drop_events[1]),
+            atomic_load(&write_errors), last_error ? ", last: " : "",
+            last_error ? strerror(last_error) : "");
+    printf("[REC] Stopped %s (dropped %llu/%llu bytes)\n", base_path,
+           atomic_load(&dropped[0]), atomic_load(&dropped[1]));
+    release_resources();
+    return 0;
+}
+
+int recorder_status(char *out, size_t size) {
+    unsigned int mask = atomic_load(&rec_mask);
+
+    if (!mask)
+        return snprintf(out, size, "record=off\n");
+    return snprintf(out, size,
+        "record=%s\nrecord_path=%s\n"
+        "record_pre_bytes=%llu\nrecord_post_bytes=%llu\n"
+        "record_dropped=%llu/%llu\nrecord_drop_events=%lu/%lu\n"
+        "record_pool_free=%u/%u\nrecord_errors=%lu\n",
+        streams_name(mask), base_path, atomic_load(&written[0]), atomic_load(&written[1]),
+        atomic_load(&dropped[0]), atomic_load(&dropped[1]),
+        atomic_load(&drop_events[0]), atomic_load(&drop_events[1]),
+        ring_count(&free_ring), nblocks, atomic_load(&write_errors));
+}
+
+void recorder_init(const struct router_conf *conf) {
+    def_streams = conf->record;
+    def_buf_kb  = conf->record_buf_kb;
+    snprintf(def_dir, sizeof(def_dir), "%s", conf->record_dir);
+
+    if (conf->record)
+        recorder_start(conf->record, conf->record_dir);
+}
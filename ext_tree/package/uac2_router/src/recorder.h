@@ -0,0 +1,44 @@
+/*
+ * Diagnostic stream recorder
+ *
+ * Writes the live stream to files for bug reports ("noise on DSD256"):
+ *   pre  — capture data exactly as received over USB (before DSD swap)
+ *   post — data exactly as written to I2S
+ *
+ * The audio thread only memcpy()s into a fixed pool of blocks
+ * (RECORD_BUF_KB); a SCHED_OTHER writer thread hands full blocks to
+ * io_uring as WRITE_FIXED on registered buffers.  When flash stalls
+ * and the pool runs dry, data is dropped and counted — the audio
+ * thread never waits for I/O.  Needs CONFIG_IO_URING in the kernel.
+ *
+ * Output in RECORD_DIR (default /data):
+ *   uac2_rec_<date>-<time>_pre.raw / _post.raw   raw 2 × 32 bit LE frames
+ *   uac2_rec_<date>-<time>.txt                   formats with byte offsets,
+ *                                                final sizes and drops
+ */
+
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stddef.h>
+
+#include "router_conf.h"
+
+#define RECORDER_PRE    0x1
+#define RECORDER_POST   0x2
+
+/* Startup: remember defaults, start at once if RECORD != off */
+void recorder_init(const struct router_conf *conf);
+
+/* Control side (main / control thread).  streams 0 and dir NULL take
+ * the configured defaults.  Return 0 or negative errno. */
+int  recorder_start(unsigned int streams, const char *dir);
+int  recorder_stop(void);
+int  recorder_status(char *out, size_t size);
+int  recorder_parse_streams(const char *name);     /* pre|post|both, -1 */
+
+/* Audio thread — no blocking, no allocation */
+void recorder_set_format(unsigned int rate, unsigned int lrck_rate, int is_dsd);
+void recorder_push(unsigned int stream, const void *data, size_t bytes);
+
+#endif /* RECORDER_H */
@@ -0,0 +1,188 @@
+/*
+ * Router configuration loader — see router_conf.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "router_conf.h"
+
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+static void set_defaults(struct router_conf *conf) {
+    conf->sched         = ROUTER_SCHED_FIFO;
+    conf->fifo_priority = 70;
+    conf->dl_margin_pct = 50;
+    conf->cpufreq            = ROUTER_CPUFREQ_PERFORMANCE;
+    conf->cpufreq_margin_pct = 100;
+    conf->cpufreq_full_lrck  = 705600;
+    conf->pcm_backend        = PCM_BACKEND_ALSA;
+    conf->tun.latency        = PC_LATENCY_NORMAL;
+    conf->tun.prebuffer      = 0;
+    conf->tun.log_level      = 0;
+    conf->tun.verify         = 0;
+    snprintf(conf->ctl_socket, sizeof(conf->ctl_socket), "%s", ROUTER_CTL_SOCKET);
+    conf->bus_frames         = 65536;
+    conf->record             = 0;
+    conf->record_buf_kb      = 4096;
+    snprintf(conf->record_dir, sizeof(conf->record_dir), "/data");
+    conf->sinks[0]           = ROUTER_SINK_I2S;
+    conf->nsinks             = 1;
+    conf->usb_card           = -1;
+    conf->play_clients       = 4;
+    conf->play_frames        = 32768;
+    conf->usb_priority       = 100;
+    conf->feedback           = ROUTER_FEEDBACK_ROUTER;
+    snprintf(conf->drift_seeds, sizeof(conf->drift_seeds), "/data/drift_seeds");
+    conf->bridge             = 0;
+    conf->dsd_swap_gadget    = 1;
+}
+
+const char *router_sink_name(enum router_sink sink) {
+    return sink == ROUTER_SINK_USB ? "usb" : "i2s";
+}
+
+/* SINKS=i2s | usb | i2s,usb | usb,i2s — duplicates and unknowns rejected */
+static int parse_sinks(struct router_conf *conf, char *val) {
+    enum router_sink list[ROUTER_MAX_SINKS];
+    unsigned int n = 0;
+    char *save;
+
+    for (char *tok = strtok_r(val, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        tok = trim(tok);
+        enum router_sink sink;
+        if (strcmp(tok, "i2s") == 0)      sink = ROUTER_SINK_I2S;
+        else if (strcmp(tok, "usb") == 0) sink = ROUTER_SINK_USB;
+        else return -1;
+        for (unsigned int i = 0; i < n; i++)
+            if (list[i] == sink) return -1;
+        if (n == ROUTER_MAX_SINKS) return -1;
+        list[n++] = sink;
+    }
+    if (n == 0) return -1;
+    memcpy(conf->sinks, list, sizeof(list[0]) * n);
+    conf->nsinks = n;
+    return 0;
+}
+
+void router_conf_load(struct router_conf *conf, const char *path) {
+    char line[256];
+    FILE *fp;
+
+    set_defaults(conf);
+
+    fp = fopen(path, "r");
+    if (!fp) return;
+
+    while (fgets(line, sizeof(line), fp)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *eq = strchr(line, '=');
+        if (!eq) continue;
+        *eq = '\0';
+        char *key = trim(line);
+        char *val = trim(eq + 1);
+
+        if (strcmp(key, "SCHED") == 0) {
+            if (strcmp(val, "deadline") == 0)
+                conf->sched = ROUTER_SCHED_DEADLINE;
+            else if (strcmp(val, "fifo") == 0)
+                conf->sched = ROUTER_SCHED_FIFO;
+            else
+                fprintf(stderr, "[CONF] Unknown SCHED=%s, using fifo\n", val);
+        } else if (strcmp(key, "FIFO_PRIO") == 0) {
+            int prio = atoi(val);
+            if (prio >= 1 && prio <= 99) conf->fifo_priority = prio;
+        } else if (strcmp(key, "DL_MARGIN") == 0) {
+            int pct = atoi(val);
+            if (pct >= 0 && pct <= 400) conf->dl_margin_pct = pct;
+        } else if (strcmp(key, "CPUFREQ") == 0) {
+            if (strcmp(val, "adaptive") == 0)
+                conf->cpufreq = ROUTER_CPUFREQ_ADAPTIVE;
+            else if (strcmp(val, "performance") == 0)
+                conf->cpufreq = ROUTER_CPUFREQ_PERFORMANCE;
+            else
+                fprintf(stderr, "[CONF] Unknown CPUFREQ=%s, using performance\n", val);
+        } else if (strcmp(key, "CPUFREQ_MARGIN") == 0) {
+            int pct = atoi(val);
+            if (pct >= 0 && pct <= 400) conf->cpufreq_margin_pct = pct;
+        } else if (strcmp(key, "CPUFREQ_FULL_LRCK") == 0) {
+            long hz = atol(val);
+            if (hz > 0) conf->cpufreq_full_lrck = hz;
+        } else if (strcmp(key, "PCM_BACKEND") == 0) {
+            if (strcmp(val, "direct") == 0)
+                conf->pcm_backend = PCM_BACKEND_DIRECT;
+            else if (strcmp(val, "alsa") == 0)
+                conf->pcm_backend = PCM_BACKEND_ALSA;
+            else
+                fprintf(stderr, "[CONF] Unknown PCM_BACKEND=%s, using alsa\n", val);
+        } else if (strcmp(key, "LATENCY") == 0) {
+            int lat = pc_latency_parse(val);
+            if (lat >= 0) conf->tun.latency = lat;
+            else fprintf(stderr, "[CONF] Unknown LATENCY=%s, using normal\n", val);
+        } else if (strcmp(key, "PREBUFFER") == 0) {
+            int n = atoi(val);
+            if (n >= 0 && n <= 64) conf->tun.prebuffer = n;
+        } else if (strcmp(key, "LOG") == 0) {
+            int lvl = atoi(val);
+            if (lvl >= 0 && lvl <= 2) conf->tun.log_level = lvl;
+        } else if (strcmp(key, "CTL_SOCKET") == 0) {
+            snprintf(conf->ctl_socket, sizeof(conf->ctl_socket), "%s", val);
+        } else if (strcmp(key, "BUS_FRAMES") == 0) {
+            conf->bus_frames = strtoul(val, NULL, 0);
+        } else if (strcmp(key, "RECORD") == 0) {
+            if (strcmp(val, "off") == 0)       conf->record = 0;
+            else if (strcmp(val, "pre") == 0)  conf->record = 1;
+            else if (strcmp(val, "post") == 0) conf->record = 2;
+            else if (strcmp(val, "both") == 0) conf->record = 3;
+            else fprintf(stderr, "[CONF] Unknown RECORD=%s, using off\n", val);
+        } else if (strcmp(key, "RECORD_DIR") == 0) {
+            if (val[0]) snprintf(conf->record_dir, sizeof(conf->record_dir), "%s", val);
+        } else if (strcmp(key, "RECORD_BUF_KB") == 0) {
+            int kb = atoi(val);
+            if (kb >= 256 && kb <= 65536) conf->record_buf_kb = kb;
+        } else if (strcmp(key, "VERIFY") == 0) {
+            if (strcmp(val, "on") == 0)       conf->tun.verify = 1;
+            else if (strcmp(val, "off") == 0) conf->tun.verify = 0;
+            else fprintf(stderr, "[CONF] Unknown VERIFY=%s, using off\n", val);
+        } else if (strcmp(key, "SINKS") == 0) {
+            if (parse_sinks(conf, val) < 0)
+                fprintf(stderr, "[CONF] Unknown SINKS=%s, using i2s\n", val);
+        } else if (strcmp(key, "USB_SINK_CARD") == 0) {
+            if (strcmp(val, "auto") == 0) conf->usb_card = -1;
+            else if (atoi(val) >= 1 && atoi(val) <= 7) conf->usb_card = atoi(val);
+        } else if (strcmp(key, "PLAY_CLIENTS") == 0) {
+            int n = atoi(val);
+            if (n >= 0 && n <= 4) conf->play_clients = n;
+        } else if (strcmp(key, "PLAY_FRAMES") == 0) {
+            conf->play_frames = strtoul(val, NULL, 0);
+        } else if (strcmp(key, "USB_PRIORITY") == 0) {
+            int prio = atoi(val);
+            if (prio >= 0 && prio <= 255) conf->usb_priority = prio;
+        } else if (strcmp(key, "FEEDBACK") == 0) {
+            if (strcmp(val, "router") == 0)      conf->feedback = ROUTER_FEEDBACK_ROUTER;
+            else if (strcmp(val, "kernel") == 0) conf->feedback = ROUTER_FEEDBACK_KERNEL;
+            else if (strcmp(val, "sof") == 0)    conf->feedback = ROUTER_FEEDBACK_SOF;
+            else fprintf(stderr, "[CONF] Unknown FEEDBACK=%s, using router\n", val);
+        } else if (strcmp(key, "DRIFT_SEEDS") == 0) {
+            snprintf(conf->drift_seeds, sizeof(conf->drift_seeds), "%s", val);
+        } else if (strcmp(key, "BRIDGE") == 0) {
+            if (strcmp(val, "on") == 0)       conf->bridge = 1;
+            else if (strcmp(val, "off") == 0) conf->bridge = 0;
+            else fprintf(stderr, "[CONF] Unknown BRIDGE=%s, using off\n", val);
+        } else if (strcmp(key, "DSD_SWAP") == 0) {
+            if (strcmp(val, "gadget") == 0)      conf->dsd_swap_gadget = 1;
+            else if (strcmp(val, "router") == 0) conf->dsd_swap_gadget = 0;
+            else fprintf(stderr, "[CONF] Unknown DSD_SWAP=%s, using gadget\n", val);
+        }
+    }
+    fclose(fp);
+}
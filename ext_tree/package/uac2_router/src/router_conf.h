@@ -0,0 +1,80 @@
+/*
+ * Router configuration — /etc/uac2_router.conf
+ *
+ * Same KEY=VALUE layout as /etc/i2s.conf: one setting per line,
+ * '#' starts a comment, unknown keys are ignored.  Missing file or
+ * missing keys fall back to the built-in defaults below.
+ */
+
+#ifndef ROUTER_CONF_H
+#define ROUTER_CONF_H
+
+#define ROUTER_CONF_FILE "/etc/uac2_router.conf"
+#define ROUTER_CTL_SOCKET "/run/uac2_router.sock"
+
+#include <purecore/pcm_io.h>
+#include <purecore/period.h>
+
+enum router_sched {
+    ROUTER_SCHED_FIFO = 0,
+    ROUTER_SCHED_DEADLINE,
+};
+
+enum router_cpufreq {
+    ROUTER_CPUFREQ_PERFORMANCE = 0,     /* leave the kernel governor alone */
+    ROUTER_CPUFREQ_ADAPTIVE,
+};
+
+enum router_sink {
+    ROUTER_SINK_I2S = 0,        /* on-board I2S DAC, card 0 */
+    ROUTER_SINK_USB,            /* USB-host DAC (snd-usb-audio) */
+};
+
+#define ROUTER_MAX_SINKS 2
+
+enum router_feedback {
+    ROUTER_FEEDBACK_ROUTER = 0,     /* drift estimator on the router's fill, feedback.h */
+    ROUTER_FEEDBACK_KERNEL,         /* leave it to the gadget's own loop */
+    ROUTER_FEEDBACK_SOF,            /* gadget's loop on the I2S position we report */
+};
+
+/* Settings that can also be changed at runtime through the control
+ * socket; applied by the audio loop at the next period boundary. */
+struct router_tunables {
+    enum pc_latency latency;        /* LATENCY=low|normal|safe, period.h */
+    unsigned int prebuffer;         /* PREBUFFER=playback periods, 0 = profile default */
+    int log_level;                  /* LOG=0 errors, 1 +status every 10 s, 2 +load windows */
+    int verify;                     /* VERIFY=off|on, CRC-32 of both streams (verify.h) */
+};
+
+struct router_conf {
+    enum router_sched sched;    /* SCHED=fifo|deadline */
+    int fifo_priority;          /* FIFO_PRIO=1..99 */
+    unsigned int dl_margin_pct; /* DL_MARGIN=% headroom over measured cost */
+    enum router_cpufreq cpufreq;        /* CPUFREQ=performance|adaptive */
+    unsigned int cpufreq_margin_pct;    /* CPUFREQ_MARGIN=% headroom at chosen OPP */
+    unsigned int cpufreq_full_lrck;     /* CPUFREQ_FULL_LRCK=Hz, pin max at/above */
+    enum pcm_backend pcm_backend;       /* PCM_BACKEND=alsa|direct */
+    struct router_tunables tun;
+    char ctl_socket[108];               /* CTL_SOCKET=path, empty = disabled */
+    unsigned long bus_frames;           /* BUS_FRAMES=audio bus ring, 0 = off */
+    unsigned int record;                /* RECORD=off|pre|post|both (RECORDER_* bits) */
+    char record_dir[64];                /* RECORD_DIR=path */
+    unsigned int record_buf_kb;         /* RECORD_BUF_KB=block pool size */
+    enum router_sink sinks[ROUTER_MAX_SINKS];   /* SINKS=i2s,usb, first is primary */
+    unsigned int nsinks;
+    int usb_card;                       /* USB_SINK_CARD=auto (-1) | card number */
+    unsigned int play_clients;          /* PLAY_CLIENTS=local players, 0 = off */
+    unsigned long play_frames;          /* PLAY_FRAMES=ring per player */
+    unsigned int usb_priority;          /* USB_PRIORITY=0..255 vs. local players */
+    enum router_feedback feedback;      /* FEEDBACK=router|kernel|sof */
+    char drift_seeds[64];               /* DRIFT_SEEDS=path, empty = off (drift_seed.h) */
+    int bridge;                         /* BRIDGE=off|on, in-kernel routing (bridge.h) */
+    int dsd_swap_gadget;                /* DSD_SWAP=gadget|router, who swaps DSD bytes */
+};
+
+void router_conf_load(struct router_conf *conf, const char *path);
+
+const char *router_sink_name(enum router_sink sink);
+
+#endif /* ROUTER_CONF_H */
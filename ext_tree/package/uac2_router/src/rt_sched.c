@@ -0,0 +1,183 @@
+/*
+ * Real-time scheduling for the router audio thread — see rt_sched.h
+ *
+ * Deadline reservation per stream:
+ *   period = deadline = capture period (the loop is paced by readi)
+ *   runtime = measured worst per-period CPU cost × (1 + DL_MARGIN)
+ *
+ * Before anything is measured, runtime is a fixed fraction of the
+ * period.  Once a stream has run, the cost per frame is remembered so
+ * the next configure_audio() starts from a rate-scaled estimate.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "rt_sched.h"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#define DL_FLAG_RESET_ON_FORK  0x01
+#define DL_FLAG_DL_OVERRUN     0x04   /* SIGXCPU on runtime overrun (4.16+) */
+
+/* glibc has no sched_setattr() wrapper; layout from uapi sched/types.h */
+struct dl_sched_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t  sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
+
+/* Reservation while opening/closing PCMs: 4 ms every 10 ms */
+#define DL_SETUP_RUNTIME_NS   4000000ULL
+#define DL_SETUP_PERIOD_NS   10000000ULL
+
+#define DL_RUNTIME_MIN_NS      100000ULL
+#define DL_RUNTIME_MAX_PCT     90     /* never reserve more than this of a period */
+#define DL_INIT_PCT_PCM        25     /* first guess before any measurement */
+#define DL_INIT_PCT_DSD        50
+
+static int dl_mode = 0;
+static uint64_t dl_flags = DL_FLAG_RESET_ON_FORK | DL_FLAG_DL_OVERRUN;
+static unsigned int margin_pct = 50;
+
+static uint64_t dl_runtime = 0;
+static uint64_t dl_period  = 0;
+static uint64_t ns_per_kframe = 0;    /* measured cost per 1024 frames, 0 = unknown */
+
+static volatile sig_atomic_t overrun_count = 0;
+static sig_atomic_t overrun_seen = 0;
+
+static void sigxcpu_handler(int sig) { overrun_count++; }
+
+static int dl_apply(uint64_t runtime, uint64_t period) {
+    struct dl_sched_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.sched_policy   = SCHED_DEADLINE;
+    attr.sched_flags    = dl_flags;
+    attr.sched_runtime  = runtime;
+    attr.sched_deadline = period;
+    attr.sched_period   = period;
+
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) < 0)
+        return -errno;
+    dl_runtime = runtime;
+    dl_period  = period;
+    return 0;
+}
+
+static uint64_t clamp_runtime(uint64_t runtime, uint64_t period) {
+    uint64_t max = period * DL_RUNTIME_MAX_PCT / 100;
+    if (runtime < DL_RUNTIME_MIN_NS) runtime = DL_RUNTIME_MIN_NS;
+    if (runtime > max) runtime = max;
+    return runtime;
+}
+
+static int fifo_apply(int prio) {
+    struct sched_param sp = { .sched_priority = prio };
+    if (sched_setscheduler(0, SCHED_FIFO, &sp) < 0) {
+        fprintf(stderr, "[RT] WARNING: Cannot set SCHED_FIFO: %s\n", strerror(errno));
+        return -1;
+    }
+    printf("[RT] SCHED_FIFO priority %d\n", prio);
+    return 0;
+}
+
+int rt_sched_init(const struct router_conf *conf) {
+    margin_pct = conf->dl_margin_pct;
+
+    if (conf->sched != ROUTER_SCHED_DEADLINE)
+        return fifo_apply(conf->fifo_priority);
+
+    signal(SIGXCPU, sigxcpu_handler);
+
+    int err = dl_apply(DL_SETUP_RUNTIME_NS, DL_SETUP_PERIOD_NS);
+    if (err == -EINVAL) {
+        /* Kernel without SCHED_FLAG_DL_OVERRUN — run without overrun signal */
+        dl_flags &= ~DL_FLAG_DL_OVERRUN;
+        err = dl_apply(DL_SETUP_RUNTIME_NS, DL_SETUP_PERIOD_NS);
+    }
+    if (err < 0) {
+        fprintf(stderr, "[RT] WARNING: Cannot set SCHED_DEADLINE: %s, falling back to FIFO\n",
+                strerror(-err));
+        signal(SIGXCPU, SIG_DFL);
+        return fifo_apply(conf->fifo_priority);
+    }
+
+    dl_mode = 1;
+    cpu_load_enable();
+    printf("[RT] SCHED_DEADLINE (margin %u%%, overrun signal %s)\n",
+           margin_pct, (dl_flags & DL_FLAG_DL_OVERRUN) ? "on" : "off");
+    return 0;
+}
+
+void rt_sched_reconfigure_begin(void) {
+    if (!dl_mode) return;
+    dl_apply(DL_SETUP_RUNTIME_NS, DL_SETUP_PERIOD_NS);
+}
+
+void rt_sched_configure(unsigned int lrck_rate, unsigned long period_frames, int is_dsd) {
+    if (!dl_mode || lrck_rate == 0 || period_frames == 0) return;
+
+    uint64_t period = (uint64_t)period_frames * 1000000000ULL / lrck_rate;
+    uint64_t runtime;
+
+    if (ns_per_kframe) {
+        /* Scale the last measured cost to the new period */
+        runtime = ns_per_kframe * period_frames / 1024;
+        runtime = runtime * (100 + margin_pct) / 100;
+    } else {
+        runtime = period * (is_dsd ? DL_INIT_PCT_DSD : DL_INIT_PCT_PCM) / 100;
+    }
+    runtime = clamp_runtime(runtime, period);
+
+    int err = dl_apply(runtime, period);
+    if (err < 0)
+        fprintf(stderr, "[RT] WARNING: deadline %llu/%llu us rejected: %s\n",
+                (unsigned long long)runtime / 1000, (unsigned long long)period / 1000,
+                strerror(-err));
+    else
+        printf("[RT] SCHED_DEADLINE runtime %llu us / period %llu us\n",
+               (unsigned long long)runtime / 1000, (unsigned long long)period / 1000);
+}
+
+int rt_sched_poll_overrun(void) {
+    if (!dl_mode || overrun_count == overrun_seen) return 0;
+    overrun_seen = overrun_count;
+
+    /* Grow by a quarter right away, don't wait for the window */
+    uint64_t grown = clamp_runtime(dl_runtime + dl_runtime / 4, dl_period);
+    if (grown != dl_runtime) dl_apply(grown, dl_period);
+    return 1;
+}
+
+void rt_sched_window(const struct cpu_load_window *w) {
+    if (!dl_mode || !w->period_frames) return;
+
+    /* Reserve worst observed cost plus margin.  Grow immediately;
+     * shrink only when at least 1/8 is reclaimable to avoid a setattr
+     * syscall every window. */
+    uint64_t target = clamp_runtime(w->max_ns * (100 + margin_pct) / 100, dl_period);
+    ns_per_kframe = w->max_ns * 1024 / w->period_frames;
+
+    if (target > dl_runtime || target < dl_runtime - dl_runtime / 8)
+        dl_apply(target, dl_period);
+}
+
+int rt_sched_is_deadline(void)         { return dl_mode; }
+uint64_t rt_sched_runtime_ns(void)     { return dl_runtime; }
+uint64_t rt_sched_period_ns(void)      { return dl_period; }
+unsigned long rt_sched_overruns(void)  { return (unsigned long)overrun_count; }
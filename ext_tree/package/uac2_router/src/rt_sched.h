@@ -0,0 +1,43 @@
+/*
+ * Real-time scheduling for the router audio thread.
+ *
+ * SCHED_FIFO (default): fixed priority, no CPU reservation.
+ * SCHED_DEADLINE: the kernel reserves `runtime` ns of CPU every
+ * capture period.  Runtime starts from a rate-derived estimate and
+ * then follows the measured per-period CPU cost plus a margin, so
+ * other RT tasks on the single A7 core cannot starve the USB bridge.
+ */
+
+#ifndef RT_SCHED_H
+#define RT_SCHED_H
+
+#include <stdint.h>
+
+#include "router_conf.h"
+#include "cpu_load.h"
+
+/* Apply the configured policy.  In deadline mode the task runs with a
+ * generous setup reservation until the first rt_sched_configure(). */
+int rt_sched_init(const struct router_conf *conf);
+
+/* Recompute the reservation for a new stream.  Called from
+ * configure_audio() once the negotiated capture period is known. */
+void rt_sched_configure(unsigned int lrck_rate, unsigned long period_frames, int is_dsd);
+
+/* Switch to the setup reservation (PCM open/close is far more expensive
+ * than a steady-state period). */
+void rt_sched_reconfigure_begin(void);
+
+/* Re-evaluate the reservation from a completed cpu_load window. */
+void rt_sched_window(const struct cpu_load_window *w);
+
+/* Check for a runtime overrun (SIGXCPU) since the last call.  Grows the
+ * runtime right away and returns 1 so the caller can react too. */
+int rt_sched_poll_overrun(void);
+
+int rt_sched_is_deadline(void);
+uint64_t rt_sched_runtime_ns(void);
+uint64_t rt_sched_period_ns(void);
+unsigned long rt_sched_overruns(void);
+
+#endif /* RT_SCHED_H */
@@ -0,0 +1,289 @@
+/*
+ * Playback sinks — see sink.h
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <alsa/asoundlib.h>
+
+#include <purecore/period.h>
+#include <purecore/swap.h>
+
+#include "sink.h"
+
+#define ROUTED_FRAME_BYTES  8           /* 2 ch × 32 bit */
+
+struct sink_format {
+    snd_pcm_format_t format;
+    enum sink_xfmt xfmt;
+};
+
+/* Probe order per stream type; I2S only ever gets the first entry */
+static const struct sink_format pcm_formats[] = {
+    { SND_PCM_FORMAT_S32_LE,     SINK_XF_COPY },
+    { SND_PCM_FORMAT_S24_3LE,    SINK_XF_S24_3LE },
+};
+
+static const struct sink_format dsd_formats[] = {
+    { SND_PCM_FORMAT_DSD_U32_LE, SINK_XF_COPY },
+    { SND_PCM_FORMAT_DSD_U32_BE, SINK_XF_BSWAP },
+    { SND_PCM_FORMAT_S32_LE,     SINK_XF_DOP32 },
+    { SND_PCM_FORMAT_S24_3LE,    SINK_XF_DOP24 },
+};
+
+static const char *const xfmt_suffix[] = {
+    [SINK_XF_NONE]    = "",
+    [SINK_XF_COPY]    = "",
+    [SINK_XF_BSWAP]   = "",
+    [SINK_XF_S24_3LE] = "",
+    [SINK_XF_DOP32]   = " (DoP)",
+    [SINK_XF_DOP24]   = " (DoP)",
+};
+
+void sink_init(struct sink *s, enum router_sink kind, int card, int blocking) {
+    memset(s, 0, sizeof(*s));
+    s->kind     = kind;
+    s->name     = router_sink_name(kind);
+    s->card     = card;
+    s->device   = 0;
+    s->blocking = blocking;
+}
+
+int sink_find_usb_card(void) {
+    char path[48];
+    for (int i = 0; i < 8; i++) {
+        snprintf(path, sizeof(path), "/proc/asound/card%d/usbid", i);
+        if (access(path, F_OK) == 0) return i;
+    }
+    return -1;
+}
+
+const char *sink_format_name(const struct sink *s) {
+    return s->pcm ? snd_pcm_format_name(s->format) : "offline";
+}
+
+/* ── Conversion (fused with the accumulator copy) ────────────────── */
+
+static void convert(struct sink *s, uint8_t *dst, const uint8_t *src, unsigned long frames) {
+    const uint32_t *in = (const uint32_t *)src;
+
+    switch (s->xfmt) {
+    case SINK_XF_COPY:
+        memcpy(dst, src, frames * ROUTED_FRAME_BYTES);
+        break;
+    case SINK_XF_BSWAP:
+        pc_dsd_swap((uint32_t *)dst, in, frames * 2);
+        break;
+    case SINK_XF_S24_3LE:
+        pc_pack_s24_3le(dst, in, frames * 2);
+        break;
+    case SINK_XF_DOP32:
+    case SINK_XF_DOP24:
+        pc_dop_encode(dst, in, frames, s->xfmt == SINK_XF_DOP24, &s->dop_phase);
+        break;
+    case SINK_XF_NONE:
+        break;
+    }
+}
+
+/* ── Open / close ─────────────────────────────────────────────────── */
+
+void sink_close(struct sink *s) {
+    if (s->pcm) pcm_io_close(s->pcm);
+    s->pcm = NULL;
+    free(s->accum);
+    free(s->prebuf);
+    s->accum = s->prebuf = NULL;
+    s->xfmt = SINK_XF_NONE;
+}
+
+static unsigned int xfmt_out_bytes(enum sink_xfmt x) {
+    return (x == SINK_XF_S24_3LE || x == SINK_XF_DOP24) ? 6 : 8;
+}
+
+int sink_open(struct sink *s, const struct sink_params *p) {
+    const struct sink_format *list = p->is_dsd ? dsd_formats : pcm_formats;
+    size_t count = p->is_dsd ? sizeof(dsd_formats) / sizeof(dsd_formats[0])
+                             : sizeof(pcm_formats) / sizeof(pcm_formats[0]);
+    int err = -EINVAL;
+
+    sink_close(s);
+    if (s->card < 0) return -ENODEV;
+    if (s->kind == ROUTER_SINK_I2S) count = 1;      /* S32_LE / DSD_U32_LE only */
+
+    for (size_t i = 0; i < count; i++) {
+        int dop = list[i].xfmt == SINK_XF_DOP32 || list[i].xfmt == SINK_XF_DOP24;
+        unsigned int ratio = dop ? 2 : 1;
+        struct pc_geometry g;
+
+        pc_playback_geometry(p->latency, p->is_dsd, s->kind == ROUTER_SINK_I2S, &g);
+
+        struct pcm_config cfg = {
+            .rate        = p->lrck_rate * ratio,
+            .format      = list[i].format,
+            .channels    = 2,
+            .period_size = g.period * ratio,
+            .buffer_size = g.buffer * ratio,
+            .period_max  = g.period_max,
+            .nonblock    = !s->blocking,
+        };
+        err = pcm_io_open(&s->pcm, p->backend, s->card, s->device, PCM_IO_PLAYBACK, &cfg);
+        if (err == 0 && s->pcm->rate != cfg.rate) {
+            /* alsa took a nearby rate: no resampling here, try the next */
+            pcm_io_close(s->pcm);
+            s->pcm = NULL;
+            err = -EINVAL;
+            continue;
+        }
+        if (err == 0) {
+            s->xfmt   = list[i].xfmt;
+            s->format = list[i].format;
+            s->ratio  = ratio;
+            break;
+        }
+        if (err == -ENOENT || err == -ENODEV) break;        /* no such card */
+    }
+    if (!s->pcm) {
+        if (p->is_dsd && s->kind != ROUTER_SINK_I2S)
+            fprintf(stderr, "[SINK] %s: no DSD or DoP support at this rate, idle\n", s->name);
+        return err;
+    }
+
+    s->out_bytes = xfmt_out_bytes(s->xfmt);
+    s->period    = s->pcm->period_size;
+    s->buffer    = s->pcm->buffer_size;
+    /* Whole routed frames per period so DoP pairs never straddle writes */
+    s->period   -= s->period % s->ratio;
+
+    s->accum      = malloc(s->period * s->out_bytes);
+    s->prebuf_max = s->buffer - s->buffer % s->ratio;
+    s->prebuf     = malloc(s->prebuf_max * s->out_bytes);
+    if (!s->accum || !s->prebuf) {
+        fprintf(stderr, "[SINK] %s: cannot allocate buffers\n", s->name);
+        sink_close(s);
+        return -ENOMEM;
+    }
+    s->accum_pos    = 0;
+    s->prebuf_fill  = 0;
+    s->prebuffering = 1;
+    s->dop_phase    = 0;
+    s->writes = s->xruns = s->drops = 0;
+    sink_set_prebuffer(s, 16);
+
+    pcm_io_prepare(s->pcm);
+
+    printf("  %s%s [%s]: %u Hz, %s%s, 2 ch, period %lu, buffer %lu\n",
+           s->pcm->name, p->backend == PCM_BACKEND_DIRECT ? " (direct)" : "", s->name,
+           s->pcm->rate, snd_pcm_format_name(s->format), xfmt_suffix[s->xfmt],
+           s->period, s->buffer);
+    return 0;
+}
+
+void sink_set_prebuffer(struct sink *s, unsigned int periods) {
+    s->prebuf_target = pc_prebuffer_frames(periods, s->period, s->prebuf_max);
+}
+
+void sink_discard_partial(struct sink *s) {
+    s->accum_pos = 0;
+}
+
+/* ── Audio path ───────────────────────────────────────────────────── */
+
+static int write_period(struct sink *s, const uint8_t *data) {
+    long avail, delay;
+
+    /* Secondary sinks never wait: no room for a whole period → drop it */
+    if (!s->blocking && pcm_io_avail_delay(s->pcm, &avail, &delay) == 0 &&
+        avail < (long)s->period) {
+        s->drops++;
+        return SINK_OK;
+    }
+
+    long wr = pcm_io_writei(s->pcm, data, s->period);
+    if (wr > 0) {
+        s->writes++;
+        return SINK_OK;
+    }
+    if (wr == -EAGAIN) {
+        s->drops++;
+        return SINK_OK;
+    }
+    if (wr == -EPIPE) {
+        /* XRUN recovery: re-enter pre-buffer phase */
+        s->xruns++;
+        fprintf(stderr, "[XRUN] Playback underrun #%lu at w=%lu (%s)\n",
+                s->xruns, s->writes, s->name);
+        pcm_io_prepare(s->pcm);
+        s->prebuffering = 1;
+        s->prebuf_fill  = 0;
+        s->accum_pos    = 0;
+        return SINK_XRUN;
+    }
+    if (wr == -ENODEV || wr == -EBADF)
+        return SINK_FAILED;
+    return SINK_OK;
+}
+
+/* Burst-write the pre-buffer.  RV1106 I2S DMA auto-starts on the first
+ * writei (start_threshold is ignored), so writing before enough data is
+ * queued drains the buffer faster than we refill it → XRUN.  Written in
+ * one go, DMA immediately has the whole pre-buffer as headroom.  A
+ * trailing partial period carries over into the accumulator. */
+static int flush_prebuffer(struct sink *s) {
+    unsigned long written = 0;
+
+    while (written + s->period <= s->prebuf_fill) {
+        int r = write_period(s, s->prebuf + written * s->out_bytes);
+        if (r != SINK_OK) return r;
+        written += s->period;
+    }
+    s->accum_pos = s->prebuf_fill - written;
+    memcpy(s->accum, s->prebuf + written * s->out_bytes, s->accum_pos * s->out_bytes);
+    s->prebuf_fill  = 0;
+    s->prebuffering = 0;
+    return SINK_STARTED;
+}
+
+int sink_feed(struct sink *s, const uint8_t *src, unsigned long frames) {
+    int result = SINK_OK;
+
+    if (!s->pcm) return SINK_OK;
+
+    while (frames) {
+        uint8_t *dst;
+        unsigned long room;
+
+        if (s->prebuffering) {
+            dst  = s->prebuf + s->prebuf_fill * s->out_bytes;
+            room = (s->prebuf_max - s->prebuf_fill) / s->ratio;
+        } else {
+            dst  = s->accum + s->accum_pos * s->out_bytes;
+            room = (s->period - s->accum_pos) / s->ratio;
+        }
+        unsigned long n = frames < room ? frames : room;
+        convert(s, dst, src, n);
+        src    += n * ROUTED_FRAME_BYTES;
+        frames -= n;
+
+        if (s->prebuffering) {
+            s->prebuf_fill += n * s->ratio;
+            if (s->prebuf_fill >= s->prebuf_target) {
+                int r = flush_prebuffer(s);
+                if (r == SINK_FAILED) return r;
+                result = r;
+            }
+        } else {
+            s->accum_pos += n * s->ratio;
+            if (s->accum_pos >= s->period) {
+                s->accum_pos = 0;
+                int r = write_period(s, s->accum);
+                if (r == SINK_FAILED) return r;
+                if (r != SINK_OK) result = r;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,93 @@
+/*
+ * Playback sinks — I2S DAC, USB-host DAC, or both (SINKS=i2s,usb)
+ *
+ * Every sink owns its playback PCM, period accumulator, pre-buffer and
+ * XRUN accounting, and is fed the routed stream (2 × 32 bit, DSD
+ * already in DSD_U32_LE order) once per capture period.
+ *
+ * The first sink is the primary: it writes blocking, exactly like the
+ * single-sink router did, and its failure reopens everything.  Further
+ * sinks are non-blocking — when a USB DAC with its own clock can't take
+ * a period it is dropped and counted, so it can never stall I2S; if it
+ * is unplugged it goes offline until the next reconfigure.
+ *
+ * Format per sink is probed at open, conversion is folded into the copy
+ * into the accumulator:
+ *   PCM  S32_LE, else S24_3LE
+ *   DSD  DSD_U32_LE native, DSD_U32_BE native (byte swap back),
+ *        else DoP at 2 × LRCK in S32_LE or S24_3LE, else idle
+ */
+
+#ifndef SINK_H
+#define SINK_H
+
+#include <stdint.h>
+
+#include "router_conf.h"
+#include <purecore/pcm_io.h>
+#include <purecore/period.h>
+
+enum sink_xfmt {
+    SINK_XF_NONE = 0,       /* no usable format: idle for this stream */
+    SINK_XF_COPY,           /* S32_LE / DSD_U32_LE as routed */
+    SINK_XF_BSWAP,          /* DSD_U32_BE */
+    SINK_XF_S24_3LE,        /* PCM, packed 24 bit */
+    SINK_XF_DOP32,          /* DSD over PCM, S32_LE container */
+    SINK_XF_DOP24,          /* DSD over PCM, S24_3LE container */
+};
+
+/* sink_feed() results */
+#define SINK_OK         0
+#define SINK_STARTED    1   /* pre-buffer written, DMA running */
+#define SINK_XRUN       2   /* underrun, back to pre-buffering */
+#define SINK_FAILED    -1   /* device gone (ENODEV/EBADF) */
+
+struct sink_params {
+    unsigned int lrck_rate;
+    int is_dsd;
+    enum pcm_backend backend;
+    enum pc_latency latency;        /* PCM period profile, period.h */
+};
+
+struct sink {
+    enum router_sink kind;
+    const char *name;
+    int card, device;
+    int blocking;
+
+    struct pcm_io *pcm;             /* NULL: closed / offline */
+    enum sink_xfmt xfmt;
+    int format;                     /* SND_PCM_FORMAT_* */
+    unsigned int out_bytes;         /* bytes per output frame */
+    unsigned int ratio;             /* output frames per routed frame */
+    unsigned long period, buffer;   /* output frames */
+
+    uint8_t *accum;
+    unsigned long accum_pos;
+    uint8_t *prebuf;
+    unsigned long prebuf_max, prebuf_fill, prebuf_target;
+    int prebuffering;
+    unsigned int dop_phase;
+
+    unsigned long writes, xruns, drops;
+};
+
+void sink_init(struct sink *s, enum router_sink kind, int card, int blocking);
+int  sink_open(struct sink *s, const struct sink_params *p);
+void sink_close(struct sink *s);
+
+/* Pre-buffer depth in sink periods, clamped to the buffer */
+void sink_set_prebuffer(struct sink *s, unsigned int periods);
+
+/* Audio thread: route `frames` frames, see SINK_* results */
+int  sink_feed(struct sink *s, const uint8_t *src, unsigned long frames);
+
+/* Capture glitch: drop the partial period */
+void sink_discard_partial(struct sink *s);
+
+const char *sink_format_name(const struct sink *s);
+
+/* First snd-usb-audio card (has /proc/asound/cardN/usbid), -1 if none */
+int  sink_find_usb_card(void);
+
+#endif /* SINK_H */
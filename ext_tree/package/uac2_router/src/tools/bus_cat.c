@@ -0,0 +1,152 @@
+/*
+ * uac2_bus_cat — dump the router's audio bus to stdout
+ *
+ * Reference consumer for audio_bus.h: attaches through the control
+ * socket, waits on its eventfd and writes raw I2S frames (2 ch × 32 bit
+ * LE; DSD_U32_LE for DSD) to stdout.  Format changes and overruns are
+ * reported on stderr.
+ *
+ *   uac2_bus_cat [-s socket] [-n frames] > capture.raw
+ *   uac2_bus_cat | nc <host> <port>
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "audio_bus.h"
+#include "router_conf.h"
+
+#define CHUNK_FRAMES 4096
+
+static volatile sig_atomic_t running = 1;
+
+static void sighandler(int sig) { running = 0; }
+
+/* Send "bus" on the control socket, receive memfd + eventfd */
+static int bus_attach(const char *path, int *memfd, int *efd) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char text[128];
+    int fds[2], slot = -1;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(fds))];
+    } cmsg;
+
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    if (send(sock, "bus\n", 4, MSG_NOSIGNAL) != 4) {
+        close(sock);
+        return -1;
+    }
+
+    struct iovec iov = { .iov_base = text, .iov_len = sizeof(text) - 1 };
+    struct msghdr msg = {
+        .msg_iov        = &iov,
+        .msg_iovlen     = 1,
+        .msg_control    = cmsg.buf,
+        .msg_controllen = sizeof(cmsg.buf),
+    };
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    close(sock);
+    if (n <= 0) return -1;
+    text[n] = '\0';
+
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_type != SCM_RIGHTS || c->cmsg_len != CMSG_LEN(sizeof(fds)) ||
+        sscanf(text, "bus slot=%d", &slot) != 1) {
+        fprintf(stderr, "%s", text);
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(c), sizeof(fds));
+    *memfd = fds[0];
+    *efd   = fds[1];
+    return slot;
+}
+
+int main(int argc, char **argv) {
+    const char *path = ROUTER_CTL_SOCKET;
+    unsigned long long limit = 0, total = 0;
+    int memfd, efd, opt;
+
+    while ((opt = getopt(argc, argv, "s:n:")) != -1) {
+        switch (opt) {
+        case 's': path = optarg; break;
+        case 'n': limit = strtoull(optarg, NULL, 0); break;
+        default:
+            fprintf(stderr, "usage: %s [-s socket] [-n frames]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int slot = bus_attach(path, &memfd, &efd);
+    if (slot < 0) return 1;
+
+    /* Header read-write (our cursor lives there), ring read-only */
+    struct audio_bus_header *hdr = mmap(NULL, AUDIO_BUS_HEADER_SIZE,
+                                        PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (hdr == MAP_FAILED || hdr->magic != AUDIO_BUS_MAGIC ||
+        hdr->version != AUDIO_BUS_VERSION) {
+        fprintf(stderr, "Incompatible audio bus\n");
+        return 1;
+    }
+    size_t ring_bytes = hdr->ring_frames * hdr->frame_bytes;
+    const uint8_t *ring = mmap(NULL, ring_bytes, PROT_READ, MAP_SHARED, memfd,
+                               hdr->header_size);
+    if (ring == MAP_FAILED) {
+        fprintf(stderr, "Cannot map bus ring: %s\n", strerror(errno));
+        return 1;
+    }
+
+    fprintf(stderr, "[bus] slot %d, %llu frames, %s %u Hz\n", slot,
+            (unsigned long long)hdr->ring_frames,
+            hdr->fmt_is_dsd ? "DSD" : "PCM", hdr->fmt_rate);
+
+    signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+    signal(SIGPIPE, sighandler);
+
+    static uint8_t chunk[CHUNK_FRAMES * AUDIO_BUS_FRAME_BYTES];
+    struct pollfd pfd = { .fd = efd, .events = POLLIN };
+
+    while (running && (!limit || total < limit)) {
+        unsigned long want = CHUNK_FRAMES;
+        if (limit && limit - total < want) want = limit - total;
+
+        long n = audio_bus_read(hdr, ring, slot, chunk, want);
+        if (n == AUDIO_BUS_FORMAT) {
+            fprintf(stderr, "[bus] %s %u Hz, %u frames/s\n",
+                    hdr->fmt_is_dsd ? "DSD" : "PCM", hdr->fmt_rate, hdr->fmt_lrck_rate);
+            continue;
+        }
+        if (n == AUDIO_BUS_OVERRUN) {
+            fprintf(stderr, "[bus] overrun #%llu\n",
+                    (unsigned long long)atomic_load(&hdr->consumers[slot].overruns));
+            continue;
+        }
+        if (n == 0) {
+            uint64_t cnt;
+            if (poll(&pfd, 1, 1000) > 0 && read(efd, &cnt, sizeof(cnt)) < 0) { }
+            continue;
+        }
+        if (fwrite(chunk, hdr->frame_bytes, n, stdout) != (size_t)n) break;
+        total += n;
+    }
+
+    fflush(stdout);
+    atomic_fetch_and(&hdr->active_mask, ~(1u << slot));
+    return 0;
+}
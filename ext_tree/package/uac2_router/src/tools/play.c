@@ -0,0 +1,218 @@
+/*
+ * uac2_play — feed raw audio from stdin to the router's outputs
+ *
+ * Reference player for play_server.h, so on-device renderers share the
+ * I2S card with USB instead of opening hw:0,0 themselves:
+ *
+ *   librespot --backend pipe --format S32 | uac2_play -r 44100 -n spotify
+ *   shairport-sync -o stdout | uac2_play -r 44100 -f s16 -p 60 -n airplay
+ *
+ * Input is interleaved stereo little-endian: s16, s24 (3 bytes) or s32
+ * PCM, or "dsd" — 32-bit words in USB RAW byte order at rate / 32
+ * frames per second (rate is then the DSD bit rate).  No data on stdin
+ * for IDLE_MS marks the player idle, so a paused renderer hands the
+ * output back; at EOF the ring is played out before exiting.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "play_server.h"
+#include "router_conf.h"
+
+#define CHUNK_FRAMES    1024
+#define IDLE_MS         200
+#define DRAIN_MS        5000
+
+static volatile sig_atomic_t running = 1;
+
+static void sighandler(int sig) { running = 0; }
+
+/* Send "play ..." on the control socket, receive memfd + two eventfds */
+static int play_attach(const char *path, const char *cmd, int fds[3]) {
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    char text[128];
+    int slot = -1;
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(3 * sizeof(int))];
+    } cmsg;
+
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0 || connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        fprintf(stderr, "Cannot connect to %s: %s\n", path, strerror(errno));
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    if (send(sock, cmd, strlen(cmd), MSG_NOSIGNAL) != (ssize_t)strlen(cmd)) {
+        close(sock);
+        return -1;
+    }
+
+    struct iovec iov = { .iov_base = text, .iov_len = sizeof(text) - 1 };
+    struct msghdr msg = {
+        .msg_iov        = &iov,
+        .msg_iovlen     = 1,
+        .msg_control    = cmsg.buf,
+        .msg_controllen = sizeof(cmsg.buf),
+    };
+    ssize_t n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    close(sock);
+    if (n <= 0) return -1;
+    text[n] = '\0';
+
+    struct cmsghdr *c = CMSG_FIRSTHDR(&msg);
+    if (!c || c->cmsg_type != SCM_RIGHTS || c->cmsg_len != CMSG_LEN(3 * sizeof(int)) ||
+        sscanf(text, "play slot=%d", &slot) != 1) {
+        fprintf(stderr, "%s", text);
+        return -1;
+    }
+    memcpy(fds, CMSG_DATA(c), 3 * sizeof(int));
+    return slot;
+}
+
+/* Input bytes per frame; 0 if unknown */
+static unsigned int in_frame_bytes(const char *fmt) {
+    if (strcmp(fmt, "s16") == 0) return 4;
+    if (strcmp(fmt, "s24") == 0) return 6;
+    if (strcmp(fmt, "s32") == 0 || strcmp(fmt, "dsd") == 0) return 8;
+    return 0;
+}
+
+/* To the ring format: S32_LE, samples MSB-aligned; s32/dsd pass through */
+static void convert(uint32_t *dst, const uint8_t *src, unsigned long frames, unsigned int fb) {
+    unsigned long samples = frames * 2;
+
+    switch (fb) {
+    case 4:
+        for (unsigned long i = 0; i < samples; i++, src += 2)
+            dst[i] = (uint32_t)src[0] << 16 | (uint32_t)src[1] << 24;
+        break;
+    case 6:
+        for (unsigned long i = 0; i < samples; i++, src += 3)
+            dst[i] = (uint32_t)src[0] << 8 | (uint32_t)src[1] << 16 | (uint32_t)src[2] << 24;
+        break;
+    default:
+        memcpy(dst, src, frames * PLAY_FRAME_BYTES);
+        break;
+    }
+}
+
+/* Ring full: arm player_waiting, re-check, then sleep on space_efd */
+static void wait_space(struct play_header *hdr, int space_efd, int timeout_ms) {
+    struct pollfd pfd = { .fd = space_efd, .events = POLLIN };
+    uint64_t cnt;
+
+    atomic_store(&hdr->player_waiting, 1);
+    if (hdr->ring_frames - (atomic_load(&hdr->write_pos) - atomic_load(&hdr->read_pos)) == 0 &&
+        poll(&pfd, 1, timeout_ms) > 0 && read(space_efd, &cnt, sizeof(cnt)) < 0) { }
+    atomic_store(&hdr->player_waiting, 0);
+}
+
+int main(int argc, char **argv) {
+    const char *path = ROUTER_CTL_SOCKET;
+    const char *fmt = "s32", *name = "";
+    unsigned long rate = 0, prio = 50;
+    int fds[3], opt;
+    char cmd[128];
+
+    while ((opt = getopt(argc, argv, "s:r:p:n:f:")) != -1) {
+        switch (opt) {
+        case 's': path = optarg; break;
+        case 'r': rate = strtoul(optarg, NULL, 0); break;
+        case 'p': prio = strtoul(optarg, NULL, 0); break;
+        case 'n': name = optarg; break;
+        case 'f': fmt  = optarg; break;
+        default:  rate = 0; break;
+        }
+    }
+    unsigned int fb = in_frame_bytes(fmt);
+    if (!rate || !fb || prio > PLAY_PRIORITY_MAX) {
+        fprintf(stderr, "usage: %s -r rate [-f s16|s24|s32|dsd] [-p 0..255] [-n name] "
+                "[-s socket] < raw\n", argv[0]);
+        return 1;
+    }
+
+    snprintf(cmd, sizeof(cmd), "play %lu %lu %s\n", rate, prio, name);
+    int slot = play_attach(path, cmd, fds);
+    if (slot < 0) return 1;
+
+    struct play_header *hdr = mmap(NULL, PLAY_HEADER_SIZE, PROT_READ | PROT_WRITE,
+                                   MAP_SHARED, fds[0], 0);
+    if (hdr == MAP_FAILED || hdr->magic != PLAY_MAGIC || hdr->version != PLAY_VERSION) {
+        fprintf(stderr, "Incompatible play server\n");
+        return 1;
+    }
+    uint8_t *ring = mmap(NULL, hdr->ring_frames * hdr->frame_bytes, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, fds[0], hdr->header_size);
+    if (ring == MAP_FAILED) {
+        fprintf(stderr, "Cannot map play ring: %s\n", strerror(errno));
+        return 1;
+    }
+    fprintf(stderr, "[play] slot %d, %llu frames, %lu Hz, priority %lu\n", slot,
+            (unsigned long long)hdr->ring_frames, rate, prio);
+
+    signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+
+    static uint8_t in[CHUNK_FRAMES * 8];
+    static uint32_t out[CHUNK_FRAMES * 2];
+    struct pollfd pin = { .fd = STDIN_FILENO, .events = POLLIN };
+    size_t have = 0;
+
+    while (running) {
+        /* Nothing on stdin for a while: paused, give the output back */
+        int r = poll(&pin, 1, IDLE_MS);
+        if (r == 0) {
+            atomic_store(&hdr->state, PLAY_IDLE);
+            continue;
+        }
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        ssize_t n = read(STDIN_FILENO, in + have, CHUNK_FRAMES * fb - have);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;                              /* EOF */
+        }
+        atomic_store(&hdr->state, PLAY_STREAMING);
+        have += n;
+
+        unsigned long frames = have / fb;
+        convert(out, in, frames, fb);
+        have -= frames * fb;
+        memmove(in, in + frames * fb, have);
+
+        const uint8_t *p = (const uint8_t *)out;
+        while (frames && running) {
+            unsigned long done = play_write(hdr, ring, fds[1], p, frames);
+            if (!done) {
+                wait_space(hdr, fds[2], 1000);
+                continue;
+            }
+            p += done * PLAY_FRAME_BYTES;
+            frames -= done;
+        }
+    }
+
+    /* Play out what is queued, unless interrupted */
+    atomic_store(&hdr->state, PLAY_CLOSED);
+    for (int waited = 0; running && waited < DRAIN_MS; waited += 50) {
+        if (atomic_load(&hdr->read_pos) == atomic_load(&hdr->write_pos))
+            break;
+        usleep(50000);
+    }
+    return 0;
+}
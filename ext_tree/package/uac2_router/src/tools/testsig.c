@@ -0,0 +1,338 @@
+/*
+ * uac2_testsig — bit-perfect test signal generator and checker
+ *
+ * The signal is self-synchronising: every 32-bit word carries the state
+ * of a maximal-length Galois LFSR (L = s[2n], R = s[2n+1]), so a checker
+ * can lock on at any frame and predict every following one.
+ *
+ *   PCM  state of `width` bits (default bits - 8), sign-extended and
+ *        placed just above the unused low bits: noise at about
+ *        -6 × (bits - width) dBFS, low (32 - bits) bits zero
+ *   DSD  full 32-bit state per word, in USB order (first byte played
+ *        first) — full-scale DSD noise, keep the volume down
+ *
+ *   uac2_testsig gen   [-f pcm|dsd] [-b bits] [-w width] [-n frames] [-r rate] [-W]
+ *                      > signal.raw|.wav
+ *        prints the values "uac2_router ctl verify" should end with
+ *   uac2_testsig check [-f pcm|dsd] [-b bits] [-w width] [-p] file
+ *        reports the first mismatching frame, exit 1 on any mismatch
+ *   uac2_testsig crc   file
+ *        CRC-32 span of any file, same rules as the router (verify.h)
+ *
+ * Files are raw 2 × 32 bit LE frames; a RIFF/WAVE header is skipped.
+ * -p: the file holds post-swap data (recorder _post.raw, uac2_bus_cat),
+ * DSD words are swapped back before checking.
+ *
+ * Host build: cc -O2 -Isrc -o uac2_testsig src/tools/testsig.c src/crc32.c src/verify.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "crc32.h"
+#include "verify.h"
+
+#define CHUNK_FRAMES 4096
+
+/* Galois taps (right shift) giving period 2^w - 1, w = 8..32 */
+static const uint32_t lfsr_taps[33] = {
+    [8]  = 0xB8,       [9]  = 0x110,      [10] = 0x240,      [11] = 0x500,
+    [12] = 0xE08,      [13] = 0x1C80,     [14] = 0x3802,     [15] = 0x6000,
+    [16] = 0xB400,     [17] = 0x12000,    [18] = 0x20400,    [19] = 0x72000,
+    [20] = 0x90000,    [21] = 0x140000,   [22] = 0x300000,   [23] = 0x420000,
+    [24] = 0xE10000,   [25] = 0x1200000,  [26] = 0x2000023,  [27] = 0x4000013,
+    [28] = 0x9000000,  [29] = 0x14000000, [30] = 0x20000029, [31] = 0x48000000,
+    [32] = 0x80200003,
+};
+
+struct signal {
+    int dsd;
+    int bits;           /* valid bits per PCM sample */
+    int width;          /* LFSR width */
+    uint32_t mask;
+};
+
+static uint32_t lfsr_next(const struct signal *sg, uint32_t s) {
+    return (s >> 1) ^ (-(s & 1) & lfsr_taps[sg->width]);
+}
+
+static uint32_t encode(const struct signal *sg, uint32_t s) {
+    if (sg->dsd) return s;
+    /* state to the top, arithmetic shift down: sign extension above,
+     * zeros in the low 32 - bits */
+    int32_t v = (int32_t)(s << (32 - sg->width));
+    return (uint32_t)(v >> (sg->bits - sg->width)) & ~(uint32_t)((1ull << (32 - sg->bits)) - 1);
+}
+
+static uint32_t decode(const struct signal *sg, uint32_t word) {
+    if (sg->dsd) return word;
+    return (word >> (32 - sg->bits)) & sg->mask;
+}
+
+static int signal_setup(struct signal *sg, int dsd, int bits, int width) {
+    sg->dsd  = dsd;
+    sg->bits = dsd ? 32 : bits;
+    if (sg->bits != 16 && sg->bits != 24 && sg->bits != 32) {
+        fprintf(stderr, "bits must be 16, 24 or 32\n");
+        return -1;
+    }
+    sg->width = dsd ? 32 : (width ? width : sg->bits - 8);
+    if (sg->width < 8 || sg->width > sg->bits) {
+        fprintf(stderr, "width must be 8..%d\n", sg->bits);
+        return -1;
+    }
+    sg->mask = sg->width == 32 ? ~0u : (1u << sg->width) - 1;
+    return 0;
+}
+
+static void put_le16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put_le32(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+/* WAVE_FORMAT_EXTENSIBLE, 2 ch, 32-bit container, `bits` valid */
+static void write_wav_header(FILE *out, unsigned int rate, int bits, unsigned long long frames) {
+    static const uint8_t pcm_guid[16] = {
+        0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x00,
+        0x80, 0x00, 0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+    };
+    uint8_t h[68];
+    uint32_t data_bytes = frames * 8 > 0xFFFFFFF0ull ? 0xFFFFFFF0u : frames * 8;
+
+    memcpy(h, "RIFF", 4);
+    put_le32(h + 4, 60 + data_bytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    put_le32(h + 16, 40);
+    put_le16(h + 20, 0xFFFE);
+    put_le16(h + 22, 2);
+    put_le32(h + 24, rate);
+    put_le32(h + 28, rate * 8);
+    put_le16(h + 32, 8);
+    put_le16(h + 34, 32);
+    put_le16(h + 36, 22);
+    put_le16(h + 38, bits);
+    put_le32(h + 40, 3);                /* FL | FR */
+    memcpy(h + 44, pcm_guid, 16);
+    memcpy(h + 60, "data", 4);
+    put_le32(h + 64, data_bytes);
+    fwrite(h, 1, sizeof(h), out);
+}
+
+/* Position `in` at the first frame: skip a RIFF header if present */
+static int skip_header(FILE *in) {
+    uint8_t h[12], ck[8];
+
+    if (fread(h, 1, 12, in) != 12 || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4))
+        return fseek(in, 0, SEEK_SET);
+    while (fread(ck, 1, 8, in) == 8) {
+        uint32_t len = ck[4] | ck[5] << 8 | ck[6] << 16 | (uint32_t)ck[7] << 24;
+        if (!memcmp(ck, "data", 4)) return 0;
+        if (fseek(in, len + (len & 1), SEEK_CUR) < 0) break;
+    }
+    fprintf(stderr, "WAV without data chunk\n");
+    return -1;
+}
+
+/* ── gen ──────────────────────────────────────────────────────────── */
+
+static int cmd_gen(const struct signal *sg, unsigned long long frames, unsigned int rate, int wav) {
+    static uint32_t chunk[CHUNK_FRAMES * 2], swapped[CHUNK_FRAMES * 2];
+    uint32_t s = 0xACE1u & sg->mask;
+
+    if (isatty(STDOUT_FILENO)) {
+        fprintf(stderr, "refusing to write audio to a terminal\n");
+        return 1;
+    }
+    if (wav) {
+        if (sg->dsd) {
+            fprintf(stderr, "-W is for PCM; play DSD raw (DSD_U32_BE on a Linux host)\n");
+            return 1;
+        }
+        write_wav_header(stdout, rate, sg->bits, frames);
+    }
+
+    verify_reset(1);
+    for (unsigned long long done = 0; done < frames; ) {
+        unsigned long n = frames - done < CHUNK_FRAMES ? frames - done : CHUNK_FRAMES;
+        for (unsigned long i = 0; i < n * 2; i++) {
+            chunk[i] = encode(sg, s);
+            s = lfsr_next(sg, s);
+            swapped[i] = sg->dsd ? __builtin_bswap32(chunk[i]) : chunk[i];
+        }
+        if (fwrite(chunk, 8, n, stdout) != n) return 1;
+        verify_push(VERIFY_PRE, chunk, n);
+        verify_push(VERIFY_POST, swapped, n);
+        done += n;
+    }
+    fflush(stdout);
+
+    fprintf(stderr, "%s, %d-bit LFSR at about %d dBFS, %llu frames\n",
+            sg->dsd ? "DSD" : "PCM", sg->width, sg->dsd ? 0 : -6 * (sg->bits - sg->width),
+            frames);
+    struct verify_stats v;
+    verify_get(&v);
+    fprintf(stderr, "expected \"uac2_router ctl verify\" after playback:\n"
+            "  verify_pre=frames=%llu crc=0x%08x\n  verify_post=frames=%llu crc=0x%08x\n",
+            v.span[VERIFY_PRE].frames, (unsigned)v.span[VERIFY_PRE].crc,
+            v.span[VERIFY_POST].frames, (unsigned)v.span[VERIFY_POST].crc);
+    return 0;
+}
+
+/* ── check ────────────────────────────────────────────────────────── */
+
+static int cmd_check(const struct signal *sg, int post, FILE *in) {
+    static uint32_t chunk[CHUNK_FRAMES * 2];
+    unsigned long long index = 0, synced_at = 0, checked = 0, mismatches = 0;
+    unsigned long long zero_run = 0, zero_at = 0, first_bad = 0, resyncs = 0;
+    int synced = 0, have_first = 0;
+    uint32_t expect = 0;                /* next state for L */
+    size_t n;
+
+    if (skip_header(in) < 0) return 2;
+    verify_reset(1);
+
+    while ((n = fread(chunk, 8, CHUNK_FRAMES, in)) > 0) {
+        if (post && sg->dsd)
+            for (size_t i = 0; i < n * 2; i++) chunk[i] = __builtin_bswap32(chunk[i]);
+        verify_push(VERIFY_PRE, chunk, n);
+
+        for (size_t i = 0; i < n; i++, index++) {
+            uint32_t l = chunk[i * 2], r = chunk[i * 2 + 1];
+
+            if ((l | r) == 0) {
+                /* silence: lead-in/out, or a dropout if signal follows */
+                if (synced && zero_run++ == 0) zero_at = index;
+                continue;
+            }
+            if (synced && zero_run) {
+                if (!have_first) { first_bad = zero_at; have_first = 1; }
+                printf("DROPOUT  at frame %llu: %llu zero frames\n", zero_at, zero_run);
+                mismatches++;
+                synced = 0;
+            }
+            zero_run = 0;
+
+            if (synced) {
+                uint32_t el = encode(sg, expect);
+                uint32_t er = encode(sg, lfsr_next(sg, expect));
+                if (l == el && r == er) {
+                    expect = lfsr_next(sg, lfsr_next(sg, expect));
+                    checked++;
+                    continue;
+                }
+                if (!have_first) { first_bad = index; have_first = 1; }
+                if (mismatches < 10)
+                    printf("MISMATCH at frame %llu (byte %llu): got %08x %08x, expected %08x %08x\n",
+                           index, index * 8, l, r, el, er);
+                mismatches++;
+                synced = 0;
+            }
+
+            /* (re)lock: this frame must be two consecutive states */
+            uint32_t s = decode(sg, l);
+            if (s && encode(sg, s) == l && encode(sg, lfsr_next(sg, s)) == r) {
+                if (checked || mismatches) resyncs++;
+                else synced_at = index;
+                synced = 1;
+                expect = lfsr_next(sg, lfsr_next(sg, s));
+                checked++;
+            }
+        }
+    }
+
+    struct verify_stats v;
+    verify_get(&v);
+    if (!checked) {
+        printf("NO SIGNAL: no frame matches the %s test signal (wrong -f/-b/-w/-p?)\n",
+               sg->dsd ? "DSD" : "PCM");
+        return 1;
+    }
+    printf("signal from frame %llu, %llu frames checked, %llu mismatches, %llu resyncs\n",
+           synced_at, checked, mismatches, resyncs);
+    printf("span: frames=%llu crc=0x%08x\n", v.span[VERIFY_PRE].frames,
+           (unsigned)v.span[VERIFY_PRE].crc);
+    if (mismatches) {
+        printf("FAIL: first mismatch at frame %llu\n", first_bad);
+        return 1;
+    }
+    printf("OK: bit-perfect\n");
+    return 0;
+}
+
+/* ── crc ──────────────────────────────────────────────────────────── */
+
+static int cmd_crc(FILE *in) {
+    static uint32_t chunk[CHUNK_FRAMES * 2];
+    size_t n;
+
+    if (skip_header(in) < 0) return 2;
+    verify_reset(1);
+    while ((n = fread(chunk, 8, CHUNK_FRAMES, in)) > 0)
+        verify_push(VERIFY_PRE, chunk, n);
+
+    struct verify_stats v;
+    verify_get(&v);
+    printf("frames=%llu crc=0x%08x skipped=%llu\n", v.span[VERIFY_PRE].frames,
+           (unsigned)v.span[VERIFY_PRE].crc, v.span[VERIFY_PRE].skipped);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "usage: %s gen   [-f pcm|dsd] [-b bits] [-w width] [-n frames] [-r rate] [-W] > file\n"
+        "       %s check [-f pcm|dsd] [-b bits] [-w width] [-p] file\n"
+        "       %s crc   file\n", prog, prog, prog);
+}
+
+int main(int argc, char **argv) {
+    unsigned long long frames = 0;
+    unsigned int rate = 0;
+    int dsd = 0, bits = 32, width = 0, wav = 0, post = 0, opt;
+    struct signal sg;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *cmd = argv[1];
+    optind = 2;
+    while ((opt = getopt(argc, argv, "f:b:w:n:r:Wp")) != -1) {
+        switch (opt) {
+        case 'f': dsd = strcmp(optarg, "dsd") == 0; break;
+        case 'b': bits = atoi(optarg); break;
+        case 'w': width = atoi(optarg); break;
+        case 'n': frames = strtoull(optarg, NULL, 0); break;
+        case 'r': rate = strtoul(optarg, NULL, 0); break;
+        case 'W': wav = 1; break;
+        case 'p': post = 1; break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    crc32_init();
+    if (signal_setup(&sg, dsd, bits, width) < 0) return 2;
+
+    if (strcmp(cmd, "gen") == 0) {
+        if (!rate) rate = dsd ? 88200 : 48000;
+        if (!frames) frames = rate * 10ull;
+        return cmd_gen(&sg, frames, rate, wav);
+    }
+
+    if (optind >= argc) {
+        usage(argv[0]);
+        return 2;
+    }
+    FILE *in = fopen(argv[optind], "rb");
+    if (!in) {
+        perror(argv[optind]);
+        return 2;
+    }
+    int ret = strcmp(cmd, "check") == 0 ? cmd_check(&sg, post, in)
+            : strcmp(cmd, "crc") == 0   ? cmd_crc(in)
+            : (usage(argv[0]), 2);
+    fclose(in);
+    return ret;
+}
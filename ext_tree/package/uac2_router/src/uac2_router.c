@@ -4,8 +4,12 @@
  * Routes audio from USB Audio Class 2 gadget to I2S DAC on RV1106 (LuckFox Pico MAX).
  * Supports PCM up to 768 kHz and native DSD64–DSD512.
  *
- * Architecture: single-thread, blocking capture ↔ accumulate ↔ blocking playback.
- * USB capture paces the loop; I2S playback follows at matched rate.
+ * Architecture: single-thread, blocking capture → per-sink accumulate → playback
+ * (sink.h).  USB capture paces the loop; the primary sink (I2S by default)
+ * follows at matched rate, an optional USB-host DAC is fed alongside.
+ * The router is the only owner of the outputs: on-device players feed it
+ * through per-player rings (play_server.h) and the highest-priority
+ * source is on air; the primary sink's writes pace a local player.
  *
  * Key constraints of RV1106 I2S:
  *   - DMA only picks up data at period boundaries (sub-period writes are invisible)
@@ -26,77 +30,72 @@
 #include <stdint.h>
 #include <sched.h>
 #include <sys/mman.h>
-/* time.h not needed — status log uses frame counter instead of time() syscall */
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+
+#include "router_conf.h"
+#include "rt_sched.h"
+#include "cpu_load.h"
+#include "cpufreq_policy.h"
+#include <purecore/purecore.h>
+#include "ctl_socket.h"
+#include "audio_bus.h"
+#include "recorder.h"
+#include "sink.h"
+#include "meter.h"
+#include "verify.h"
+#include "play_server.h"
+#include "feedback.h"
+#include "bridge.h"
+#include "gadget_status.h"
+/* Status log uses the frame counter instead of time(); time.h is for the
+ * bridge supervisor, which has no frames to count */
 
 /* ── Device constants ─────────────────────────────────────────────── */
 
-#define I2S_CARD        "hw:0,0"
+#define I2S_CARD        0
 #define SYSFS_UAC2_PATH "/sys/class/u_audio"
 #define SYSFS_RATE_FILE      "rate"
 #define SYSFS_FORMAT_FILE    "format"
 #define SYSFS_CHANNELS_FILE  "channels"
 
 #define I2S_FORMAT_PCM  SND_PCM_FORMAT_S32_LE
-#define I2S_FORMAT_DSD  SND_PCM_FORMAT_DSD_U32_LE
 #define I2S_CHANNELS    2
+#define CAPTURE_FRAME_BYTES (I2S_CHANNELS * 4)
 
 #define UEVENT_BUFFER_SIZE  4096
 #define MAX_CONSECUTIVE_ERRORS 50
-#define PERIOD_FRAMES   512
-
-/* ── DSD rate tables ──────────────────────────────────────────────── */
-
-#define DSD64_RATE       2822400
-#define DSD128_RATE      5644800
-#define DSD256_RATE     11289600
-#define DSD512_RATE     22579200
-#define DSD64_RATE_48    3072000
-#define DSD128_RATE_48   6144000
-#define DSD256_RATE_48  12288000
-#define DSD512_RATE_48  24576000
-
-/* Byte-swap macro for DSD 32-bit words.
- * USB RAW_DATA sends DSD bytes oldest-first: [B0(oldest) B1 B2 B3(newest)]
- * ALSA DSD_U32_LE stores oldest at MSB:      [B3(oldest) B2 B1 B0(newest)]
- * Without bswap → violet noise on I2S. */
-#define BSWAP32(x) (((x) >> 24) | (((x) >> 8) & 0xFF00) | \
-                    (((x) << 8) & 0xFF0000) | ((x) << 24))
+#define LOAD_FILE       "/run/uac2_router.load"
 
 /* ── Globals ──────────────────────────────────────────────────────── */
 
 static volatile int running = 1;
-static snd_pcm_t *pcm_capture  = NULL;
-static snd_pcm_t *pcm_playback = NULL;
+static struct pcm_io *pcm_capture  = NULL;
+static struct sink sinks[ROUTER_MAX_SINKS];     /* [0] is the primary */
+static unsigned int nsinks;
 static char uac_card_path[256] = "";
 static char uac_card_name[64]  = "";
 static int  is_current_dsd = 0;
-static snd_pcm_uframes_t playback_period = 1024;
+static int  gadget_dsd_swap = 0;    /* USB DSD arrives as DSD_U32_LE */
+static struct router_conf conf;
+static int load_fd = -1;
+static struct router_stats stats;   /* published to the control socket */
+static char *buffer;                /* one loop pass, routed format */
+static size_t buffer_size;
+
+#define SOURCE_USB      (-1)            /* else a play_server slot */
+#define USB_IDLE_MS     50              /* no capture period this long → USB idle */
+
+static int source = SOURCE_USB;
+static unsigned int usb_rate;       /* host rate, 0 = not streamed yet */
+static int usb_active;              /* host is sending */
+static unsigned int out_rate;       /* sinks are open at this rate, 0 = closed */
+static unsigned int src_rate;       /* rate of the source on air */
+static unsigned long src_period;    /* frames per loop pass */
 
 static void sighandler(int sig) { running = 0; }
 
-/* ── DSD helpers ──────────────────────────────────────────────────── */
-
-static int is_dsd_rate(unsigned int rate) {
-    return (rate == DSD64_RATE    || rate == DSD128_RATE    ||
-            rate == DSD256_RATE   || rate == DSD512_RATE    ||
-            rate == DSD64_RATE_48 || rate == DSD128_RATE_48 ||
-            rate == DSD256_RATE_48|| rate == DSD512_RATE_48);
-}
-
-static const char *get_dsd_name(unsigned int rate) {
-    switch (rate) {
-        case DSD64_RATE:     return "DSD64/44.1";
-        case DSD128_RATE:    return "DSD128/44.1";
-        case DSD256_RATE:    return "DSD256/44.1";
-        case DSD512_RATE:    return "DSD512/44.1";
-        case DSD64_RATE_48:  return "DSD64/48";
-        case DSD128_RATE_48: return "DSD128/48";
-        case DSD256_RATE_48: return "DSD256/48";
-        case DSD512_RATE_48: return "DSD512/48";
-        default: return "Unknown";
-    }
-}
-
 /* ── Sysfs / UAC helpers ─────────────────────────────────────────── */
 
 static int find_uac_card(void) {
@@ -126,6 +125,36 @@ static int read_sysfs_int(const char *filename) {
     return value;
 }
 
+/* "requests buffer_bytes period_bytes [coal]" for the stream; -1 without it */
+static int read_capture_provision(unsigned int *reqs, unsigned int *buf_bytes,
+                                  unsigned int *prd_bytes) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/capture_provision", uac_card_path);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    int n = fscanf(fp, "%u %u %u", reqs, buf_bytes, prd_bytes);
+    fclose(fp);
+    return n == 3 && *buf_bytes && *prd_bytes ? 0 : -1;
+}
+
+/* DSD_SWAP: hand the byte swap to u_audio's capture copy, or take it
+ * back from a previous run.  1 if the gadget delivers DSD_U32_LE. */
+static int setup_dsd_swap(int gadget) {
+    char path[512], line[32], layout[16];
+    int enabled = 0;
+    snprintf(path, sizeof(path), "%s/capture_dsd_swap", uac_card_path);
+    int fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) return 0;                   /* stock u_audio: router swaps */
+    if (write(fd, gadget ? "1" : "0", 1) != 1)
+        fprintf(stderr, "[DSD] %s: %s\n", path, strerror(errno));
+    ssize_t len = pread(fd, line, sizeof(line) - 1, 0);
+    close(fd);
+    if (len <= 0) return 0;
+    line[len] = '\0';
+    if (sscanf(line, "%d %15s", &enabled, layout) != 2) return 0;
+    return enabled && strcmp(layout, "DSD_U32_LE") == 0;
+}
+
 /* ── Netlink uevent socket ────────────────────────────────────────── */
 
 static int create_uevent_socket(void) {
@@ -147,215 +176,464 @@ static int create_uevent_socket(void) {
     return sock;
 }
 
+/* ── Gadget stream changes ────────────────────────────────────────
+ *
+ * /dev/uac_card<N> (gadget_status.h) delivers each change as one record
+ * carrying the whole stream descriptor: drain what is pending and act
+ * once, on the last.  A stock u_audio has no such device; then a
+ * u_audio uevent means "read <uac_card>/rate again".  Returns the
+ * host's rate when it differs from usb_rate, else 0.
+ */
+static int uevent_sock = -1;
+
+static int usb_rate_changed(char *uevent_buf, size_t size) {
+    struct gadget_event ev;
+    int rate = 0, got, n;
+
+    while ((got = gadget_event_read(&ev)) > 0) {
+        if (conf.tun.log_level >= 2)
+            printf("[EVENT] #%u %s dir=%u value=%d rate=%u alt=%u%s\n", ev.seq,
+                   gadget_event_name(ev.type), ev.dir, ev.value, ev.rate,
+                   ev.as_out_alt, ev.dropped ? " (events lost)" : "");
+        if (ev.dir != 0)
+            continue;
+        switch (ev.type) {
+        case GADGET_EVENT_SET_RATE:
+        case GADGET_EVENT_ALT_CHANGE:
+        case GADGET_EVENT_START:
+            if (ev.as_out_alt)
+                usb_active = 1;     /* host (re)starting the stream */
+            rate = ev.rate;
+            break;
+        case GADGET_EVENT_STOP:
+            usb_active = 0;
+            break;
+        }
+    }
+    if (got < 0) {
+        /* No event channel (stock u_audio or unbound): uevents */
+        if (uevent_sock < 0 && (uevent_sock = create_uevent_socket()) < 0)
+            return 0;
+        while ((n = recv(uevent_sock, uevent_buf, size - 1, MSG_DONTWAIT)) > 0) {
+            uevent_buf[n] = '\0';
+            if (strstr(uevent_buf, "u_audio") && strstr(uevent_buf, uac_card_name)) {
+                usb_active = 1;     /* rate set or capture (re)started */
+                rate = read_sysfs_int(SYSFS_RATE_FILE);
+            }
+        }
+    }
+    return rate > 0 && rate != (int)usb_rate ? rate : 0;
+}
+
+/* What to poll() for usb_rate_changed() */
+static int usb_event_fd(void) {
+    int fd = gadget_event_fd();
+    return fd >= 0 ? fd : uevent_sock;
+}
+
 /* ── PCM setup ────────────────────────────────────────────────────── */
 
-static int setup_pcm(snd_pcm_t **pcm, const char *device, snd_pcm_stream_t stream,
-                     unsigned int rate, snd_pcm_format_t format, unsigned int channels,
-                     int is_dsd)
+/* UAC2 capture — always S32_LE (DSD arrives as raw 32-bit at LRCK rate) */
+static int setup_capture(int card, unsigned int rate, int is_dsd)
 {
-    snd_pcm_hw_params_t *hw_params;
-    snd_pcm_sw_params_t *sw_params;
-    int err;
-    snd_pcm_uframes_t period_size, buffer_size;
-
-    if (is_dsd) {
-        period_size = 512;
-        buffer_size = (stream == SND_PCM_STREAM_CAPTURE) ? 65536 : 32768;
-    } else {
-        period_size = PERIOD_FRAMES;
-        if (stream == SND_PCM_STREAM_CAPTURE) {
-            period_size = 512;
-            if (rate > 192000) period_size = 1024;
-        }
-        buffer_size = period_size * 16;
-        /* Capture: scale buffer to give PI controller ~180ms headroom
-         * at any rate (same as 8192 frames at 44.1k). */
-        if (stream == SND_PCM_STREAM_CAPTURE)
-            buffer_size = 65536;
+    struct pc_geometry g;
+
+    pc_capture_geometry(rate, is_dsd, &g);
+    /* Patched u_audio limits the buffer to the stream (capture_provision) */
+    unsigned int reqs, buf_bytes, prd_bytes;
+    if (read_capture_provision(&reqs, &buf_bytes, &prd_bytes) == 0) {
+        if (g.buffer > buf_bytes / CAPTURE_FRAME_BYTES)
+            g.buffer = buf_bytes / CAPTURE_FRAME_BYTES;
+        if (g.period > prd_bytes / CAPTURE_FRAME_BYTES)
+            g.period = prd_bytes / CAPTURE_FRAME_BYTES;
+        if (conf.tun.log_level >= 1)
+            printf("  gadget: %u requests, buffer <= %u bytes\n", reqs, buf_bytes);
     }
+    struct pcm_config cfg = {
+        .rate        = rate,
+        .format      = I2S_FORMAT_PCM,
+        .channels    = I2S_CHANNELS,
+        .period_size = g.period,
+        .buffer_size = g.buffer,
+    };
 
-    if ((err = snd_pcm_open(pcm, device, stream, 0)) < 0) {
-        fprintf(stderr, "Cannot open %s: %s\n", device, snd_strerror(err));
-        return err;
-    }
+    int err = pcm_io_open(&pcm_capture, conf.pcm_backend, card, 0, SND_PCM_STREAM_CAPTURE, &cfg);
+    if (err < 0) return err;
 
-    snd_pcm_hw_params_alloca(&hw_params);
-    snd_pcm_hw_params_any(*pcm, hw_params);
-    snd_pcm_hw_params_set_access(*pcm, hw_params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(*pcm, hw_params, format);
-    snd_pcm_hw_params_set_channels(*pcm, hw_params, channels);
-    snd_pcm_hw_params_set_rate_near(*pcm, hw_params, &rate, 0);
-
-    /* Cap DSD playback period — RV1106 DMA ignores sub-period writes */
-    if (is_dsd && stream == SND_PCM_STREAM_PLAYBACK) {
-        snd_pcm_uframes_t pmax = period_size;
-        snd_pcm_hw_params_set_period_size_max(*pcm, hw_params, &pmax, 0);
-    }
-    snd_pcm_hw_params_set_period_size_near(*pcm, hw_params, &period_size, 0);
-    snd_pcm_hw_params_set_buffer_size_near(*pcm, hw_params, &buffer_size);
-
-    if ((err = snd_pcm_hw_params(*pcm, hw_params)) < 0) {
-        fprintf(stderr, "Cannot set hw params for %s: %s\n", device, snd_strerror(err));
-        snd_pcm_close(*pcm);
-        *pcm = NULL;
-        return err;
+    printf("  %s%s: %u Hz, %s, %u ch, period %lu, buffer %lu\n",
+           pcm_capture->name, conf.pcm_backend == PCM_BACKEND_DIRECT ? " (direct)" : "",
+           pcm_capture->rate, snd_pcm_format_name(I2S_FORMAT_PCM), I2S_CHANNELS,
+           pcm_capture->period_size, pcm_capture->buffer_size);
+    return 0;
+}
+
+static void close_pcms(void) {
+    if (pcm_capture) { pcm_io_close(pcm_capture); pcm_capture = NULL; }
+    for (unsigned int i = 0; i < nsinks; i++)
+        sink_close(&sinks[i]);
+    out_rate = 0;
+    feedback_hold();
+}
+
+/* SINKS order, primary blocking; the USB card is looked up on every
+ * configure so a DAC plugged in later is found by "ctl reconfigure" */
+static void sinks_init(void) {
+    nsinks = conf.nsinks;
+    for (unsigned int i = 0; i < nsinks; i++) {
+        int card = I2S_CARD;
+        if (conf.sinks[i] == ROUTER_SINK_USB)
+            card = conf.usb_card >= 0 ? conf.usb_card : sink_find_usb_card();
+        sink_init(&sinks[i], conf.sinks[i], card, i == 0);
     }
+}
 
-    snd_pcm_hw_params_get_period_size(hw_params, &period_size, 0);
-    snd_pcm_hw_params_get_buffer_size(hw_params, &buffer_size);
+static void sinks_stats(void) {
+    stats.nsinks = nsinks;
+    for (unsigned int i = 0; i < nsinks; i++) {
+        stats.sinks[i].kind   = sinks[i].kind;
+        stats.sinks[i].format = sinks[i].pcm ? sink_format_name(&sinks[i]) : NULL;
+        stats.sinks[i].period = sinks[i].period;
+        stats.sinks[i].writes = sinks[i].writes;
+        stats.sinks[i].xruns  = sinks[i].xruns;
+        stats.sinks[i].drops  = sinks[i].drops;
+    }
+    stats.write_count = sinks[0].writes;
+    stats.xrun_count  = sinks[0].xruns;
+}
 
-    snd_pcm_sw_params_alloca(&sw_params);
-    snd_pcm_sw_params_current(*pcm, sw_params);
-    snd_pcm_sw_params_set_start_threshold(*pcm, sw_params, buffer_size / 2);
-    snd_pcm_sw_params_set_avail_min(*pcm, sw_params, period_size);
-    snd_pcm_sw_params(*pcm, sw_params);
+/* ── Audio configuration ──────────────────────────────────────────
+ *
+ * Capture always runs at the USB host's rate; the sinks run at the rate
+ * of the source on air.  The two are reconfigured separately so that a
+ * source switch at an unchanged rate / PCM↔DSD mode never touches the
+ * output clock (see switch_source()).
+ */
 
-    printf("  %s: %u Hz, %s, %u ch, period %lu, buffer %lu\n",
-           device, rate, snd_pcm_format_name(format), channels,
-           (unsigned long)period_size, (unsigned long)buffer_size);
+static unsigned int prebuffer_periods(void) {
+    return conf.tun.prebuffer ? conf.tun.prebuffer
+                              : pc_latency_prebuffer(conf.tun.latency);
+}
 
+static int reserve_buffer(unsigned long frames) {
+    size_t size = frames * I2S_CHANNELS * 4;
+    if (size <= buffer_size) return 0;
+    char *p = realloc(buffer, size);
+    if (!p) { fprintf(stderr, "Cannot allocate buffer\n"); return -1; }
+    buffer = p;
+    buffer_size = size;
     return 0;
 }
 
-static void close_pcms(void) {
-    if (pcm_capture)  { snd_pcm_drop(pcm_capture);  snd_pcm_close(pcm_capture);  pcm_capture  = NULL; }
-    if (pcm_playback) { snd_pcm_drop(pcm_playback); snd_pcm_close(pcm_playback); pcm_playback = NULL; }
-}
+/* USB capture at the host rate, started right away so USB data begins
+ * filling the buffer; it keeps running while a local player is on air */
+static int open_capture(unsigned int rate, int card) {
+    int is_dsd = pc_is_dsd_rate(rate);
 
-/* ── Audio configuration ──────────────────────────────────────────── */
+    if (pcm_capture) { pcm_io_close(pcm_capture); pcm_capture = NULL; }
+    if (setup_capture(card, pc_lrck_rate(rate), is_dsd) < 0)
+        return -1;
+    if (reserve_buffer(pcm_capture->period_size) < 0) {
+        pcm_io_close(pcm_capture);
+        pcm_capture = NULL;
+        return -1;
+    }
+    pcm_io_prepare(pcm_capture);
+    pcm_io_start(pcm_capture);
 
-static int configure_audio(unsigned int rate, int card, char **buffer, size_t *buf_size,
-                           snd_pcm_uframes_t *period_size_out) {
-    int is_dsd = is_dsd_rate(rate);
-    snd_pcm_format_t i2s_format = is_dsd ? I2S_FORMAT_DSD : I2S_FORMAT_PCM;
-    unsigned int lrck_rate = is_dsd ? rate / 32 : rate;
+    stats.cap_period = pcm_capture->period_size;
+    stats.cap_buffer = pcm_capture->buffer_size;
+    return 0;
+}
 
-    is_current_dsd = is_dsd;
+/* Sinks at the on-air rate — the only place the output clock changes */
+static int open_sinks(unsigned int rate) {
+    int is_dsd = pc_is_dsd_rate(rate);
+    unsigned int lrck_rate = pc_lrck_rate(rate);
 
     if (is_dsd)
-        printf("\n[CONFIG] DSD MODE: %s (%u Hz, LRCK %u)\n", get_dsd_name(rate), rate, lrck_rate);
+        printf("\n[CONFIG] DSD MODE: %s (%u Hz, LRCK %u)\n", pc_dsd_name(rate), rate, lrck_rate);
     else
         printf("\n[CONFIG] PCM: %u Hz, 32-bit, Stereo\n", rate);
 
-    close_pcms();
+    for (unsigned int i = 0; i < nsinks; i++)
+        sink_close(&sinks[i]);
+    out_rate = 0;
 
-    /* UAC2 capture — always S32_LE (DSD arrives as raw 32-bit at LRCK rate) */
-    char uac_device[32];
-    sprintf(uac_device, "hw:%d,0", card);
-    if (setup_pcm(&pcm_capture, uac_device, SND_PCM_STREAM_CAPTURE,
-                  lrck_rate, I2S_FORMAT_PCM, I2S_CHANNELS, is_dsd) < 0)
+    /* Sinks — DSD_U32_LE for DSD, S32_LE for PCM on I2S; see sink.h */
+    struct sink_params sp = {
+        .lrck_rate  = lrck_rate,
+        .is_dsd     = is_dsd,
+        .backend    = conf.pcm_backend,
+        .latency    = conf.tun.latency,
+    };
+    sinks_init();
+    for (unsigned int i = 0; i < nsinks; i++) {
+        if (sink_open(&sinks[i], &sp) == 0) {
+            sink_set_prebuffer(&sinks[i], prebuffer_periods());
+            continue;
+        }
+        if (i == 0) {
+            for (unsigned int j = 0; j < nsinks; j++)
+                sink_close(&sinks[j]);
+            return -1;
+        }
+        printf("[SINK] %s: not available\n", sinks[i].name);
+    }
+    if (reserve_buffer(sinks[0].period) < 0) {
+        for (unsigned int i = 0; i < nsinks; i++)
+            sink_close(&sinks[i]);
         return -1;
+    }
 
-    /* I2S playback — DSD_U32_LE for DSD, S32_LE for PCM */
-    if (setup_pcm(&pcm_playback, I2S_CARD, SND_PCM_STREAM_PLAYBACK,
-                  lrck_rate, i2s_format, I2S_CHANNELS, is_dsd) < 0) {
+    out_rate       = rate;
+    is_current_dsd = is_dsd;
+    audio_bus_set_format(rate, lrck_rate, is_dsd);
+    recorder_set_format(rate, lrck_rate, is_dsd);
+    meter_configure(lrck_rate, is_dsd);
+    feedback_configure(lrck_rate);
+
+    memset(&stats.meter, 0, sizeof(stats.meter));
+    stats.rate       = rate;
+    stats.lrck_rate  = lrck_rate;
+    stats.is_dsd     = is_dsd;
+    stats.pb_period  = sinks[0].period;
+    stats.pb_buffer  = sinks[0].buffer;
+    stats.prebuffer_periods = sinks[0].prebuf_target / sinks[0].period;
+    return 0;
+}
+
+/* The loop is paced by whoever feeds the sinks: capture periods for
+ * USB, playback periods for a local player */
+static void configure_pacing(void) {
+    unsigned int lrck_rate = stats.lrck_rate;
+
+    src_period = (source == SOURCE_USB && pcm_capture) ? pcm_capture->period_size
+                                                       : sinks[0].period;
+    cpu_load_configure(lrck_rate, src_period);
+    rt_sched_configure(lrck_rate, src_period, is_current_dsd);
+    cpufreq_policy_configure(lrck_rate, is_current_dsd);
+    verify_reset(conf.tun.verify);      /* new stream, new span */
+    verify_get(&stats.verify);
+}
+
+/* Full reopen: sinks at `rate`, capture too when with_capture is set */
+static int configure_audio(unsigned int rate, int card, int with_capture) {
+    rt_sched_reconfigure_begin();
+    cpufreq_policy_boost();
+    if (with_capture)
+        close_pcms();
+
+    if (with_capture && usb_rate > 0 && open_capture(usb_rate, card) < 0 &&
+        source == SOURCE_USB)
+        return -1;
+    if (open_sinks(rate) < 0) {
         close_pcms();
         return -1;
     }
+    configure_pacing();
+    stats.reconfig_count++;
+
+    printf("[CONFIG] OK, %s period=%lu, playback period=%lu\n\n",
+           source == SOURCE_USB ? "capture" : "source",
+           src_period, (unsigned long)sinks[0].period);
+    fflush(stdout);
+    return 0;
+}
 
-    /* Read negotiated period sizes */
-    snd_pcm_hw_params_t *hw;
-    snd_pcm_hw_params_alloca(&hw);
+/* ── Sources ──────────────────────────────────────────────────────
+ *
+ * USB capture or one local player (play_server.h) is on air.  Once per
+ * period the highest-priority ready source is picked; USB counts as
+ * ready while the host is sending (stream event or capture data seen) and
+ * goes idle after USB_IDLE_MS without a capture period.
+ */
 
-    snd_pcm_hw_params_current(pcm_capture, hw);
-    snd_pcm_uframes_t cap_period;
-    snd_pcm_hw_params_get_period_size(hw, &cap_period, 0);
+static void set_source_name(int src) {
+    if (src == SOURCE_USB)
+        snprintf(stats.source, sizeof(stats.source), "usb");
+    else
+        snprintf(stats.source, sizeof(stats.source), "local:%s", play_server_name(src));
+}
 
-    snd_pcm_hw_params_current(pcm_playback, hw);
-    snd_pcm_uframes_t pb_period;
-    snd_pcm_hw_params_get_period_size(hw, &pb_period, 0);
+static int arbitrate(unsigned int *rate) {
+    unsigned int prio;
+    int best = play_server_pick(rate, &prio);
 
-    *period_size_out = cap_period;
-    playback_period = pb_period;
+    if (best < 0 || (usb_active && pcm_capture && conf.usb_priority >= prio)) {
+        *rate = usb_rate;
+        return SOURCE_USB;
+    }
+    return best;
+}
 
-    /* Allocate capture buffer (large enough for max period) */
-    snd_pcm_uframes_t max_period = (cap_period > pb_period) ? cap_period : pb_period;
-    size_t frame_bytes = I2S_CHANNELS * 4;
-    *buf_size = max_period * frame_bytes;
-    *buffer = realloc(*buffer, *buf_size);
-    if (!*buffer) { fprintf(stderr, "Cannot allocate buffer\n"); close_pcms(); return -1; }
+/* Off air, capture keeps running; only look at its fill level */
+static void watch_usb(void) {
+    long avail, delay;
+
+    if (!pcm_capture || usb_active) return;
+    int err = pcm_io_avail_delay(pcm_capture, &avail, &delay);
+    if (err == -EPIPE) {
+        pcm_io_prepare(pcm_capture);
+        pcm_io_start(pcm_capture);
+        usb_active = 1;
+    } else if (err == 0 && avail >= (long)pcm_capture->period_size) {
+        usb_active = 1;
+    }
+}
 
-    /* Prepare and start capture — USB data begins filling the buffer */
-    snd_pcm_prepare(pcm_capture);
-    snd_pcm_prepare(pcm_playback);
-    snd_pcm_start(pcm_capture);
+static int switch_source(int to, unsigned int rate, int card) {
+    printf("[SOURCE] %s -> ", stats.source);
+    if (source >= 0) play_server_on_air(source, 0);
+    source = to;
+    if (to >= 0) play_server_on_air(to, 1);
+    src_rate = rate;
+    set_source_name(to);
+    printf("%s (%u Hz)\n", stats.source, rate);
+    stats.source_switches++;
+    feedback_hold();                    /* new feed, new operating point */
+
+    if (to == SOURCE_USB && pcm_capture) {
+        /* Drop what piled up while off air, keep hw_params */
+        pcm_io_drop(pcm_capture);
+        pcm_io_prepare(pcm_capture);
+        pcm_io_start(pcm_capture);
+    }
+    if (rate == 0)
+        return 0;                       /* USB never streamed: nothing to open */
 
-    printf("[CONFIG] OK, capture period=%lu, playback period=%lu\n\n",
-           (unsigned long)cap_period, (unsigned long)pb_period);
-    fflush(stdout);
-    return 0;
+    if (sinks[0].pcm && rate == out_rate) {
+        /* Same clock: the sinks keep running, only the feed changes */
+        configure_pacing();
+        return 0;
+    }
+    return configure_audio(rate, card, 0);
 }
 
-/* ── Pre-buffer: accumulate real data before first writei ─────────
- *
- * RV1106 I2S DMA auto-starts on the first snd_pcm_writei(), ignoring
- * start_threshold.  If we write before enough data is available, DMA
- * drains the buffer faster than we refill it → XRUN.
+/* ── CPU load accounting ──────────────────────────────────────────
  *
- * Solution: read from USB capture into a pre-buffer until we have
- * enough data to fill half the playback buffer, THEN burst-write it
- * all.  DMA starts and immediately has ~23 ms of headroom.
+ * Once per steady-state capture period.  Completed windows feed the
+ * SCHED_DEADLINE budget and the cpufreq policy, and are published to
+ * LOAD_FILE (tmpfs) for monitoring:
+ *   util=<max cost/period, 0.1%> max_us avg_us period_us khz runtime_us
+ */
+static void publish_load(const struct cpu_load_window *w) {
+    char line[160];
+    if (load_fd < 0) return;
+    int len = snprintf(line, sizeof(line),
+        "util=%u.%u%% max_us=%llu avg_us=%llu period_us=%llu khz=%u runtime_us=%llu\n",
+        w->util_permille / 10, w->util_permille % 10,
+        (unsigned long long)w->max_ns / 1000, (unsigned long long)w->avg_ns / 1000,
+        (unsigned long long)w->period_ns / 1000, cpufreq_policy_cur_khz(),
+        (unsigned long long)rt_sched_runtime_ns() / 1000);
+    if (ftruncate(load_fd, 0) < 0 || pwrite(load_fd, line, len, 0) != len)
+        return;
+}
+
+static void account_period(void) {
+    struct cpu_load_window w;
+
+    if (rt_sched_poll_overrun())
+        cpufreq_policy_boost();
+    if (cpu_load_period_done(&w)) {
+        rt_sched_window(&w);
+        cpufreq_policy_window(&w);
+        publish_load(&w);
+        stats.util_permille = w.util_permille;
+        if (conf.tun.log_level >= 2)
+            printf("[LOAD] util=%u.%u%% max=%lluus avg=%lluus khz=%u\n",
+                   w.util_permille / 10, w.util_permille % 10,
+                   (unsigned long long)w.max_ns / 1000, (unsigned long long)w.avg_ns / 1000,
+                   cpufreq_policy_cur_khz());
+    }
+    stats.cpu_khz       = cpufreq_policy_cur_khz();
+    stats.dl_runtime_ns = rt_sched_runtime_ns();
+    stats.tun           = conf.tun;
+    ctl_socket_publish(&stats);
+}
+
+/* Missed deadline (XRUN): full clock right away, restart the window */
+static void period_missed(void) {
+    cpufreq_policy_boost();
+    cpu_load_reset();
+}
+
+/* ── In-kernel bridge supervisor ──────────────────────────────────
  *
- * Returns: number of frames pre-buffered, or -1 on error.
+ * BRIDGE=on and the gadget took the I2S (bridge.h): nothing to route.
+ * Rate changes are only logged, the kernel follows them itself; the
+ * bridge's counters go to the control socket once a second and, at
+ * LOG>=1, to the status line every 10 s.
  */
-static int prebuffer_from_capture(char *cap_buf, snd_pcm_uframes_t cap_period,
-                                  snd_pcm_uframes_t pb_period,
-                                  char *prebuf, size_t prebuf_max_frames,
-                                  snd_pcm_uframes_t target_frames)
-{
-    const size_t frame_bytes = I2S_CHANNELS * 4;
-    snd_pcm_uframes_t collected = 0;
-    int errors = 0;
+static void supervise_bridge(char *uevent_buf, size_t size) {
+    struct bridge_status st;
+    struct timespec now;
+    time_t last_publish = 0, last_status = 0;
 
-    while (collected < target_frames && running) {
-        snd_pcm_sframes_t frames = snd_pcm_readi(pcm_capture, cap_buf, cap_period);
-        if (frames > 0) {
-            errors = 0;
-            /* DSD byte-swap */
-            if (is_current_dsd) {
-                uint32_t *w = (uint32_t *)cap_buf;
-                size_t nwords = frames * I2S_CHANNELS;
-                for (size_t i = 0; i < nwords; i++)
-                    w[i] = BSWAP32(w[i]);
+    snprintf(stats.source, sizeof(stats.source), "bridge");
+    while (running) {
+        struct pollfd pfd = { .fd = usb_event_fd(), .events = POLLIN };
+
+        if (poll(&pfd, 1, 1000) > 0) {
+            int rate = usb_rate_changed(uevent_buf, size);
+            if (rate > 0) {
+                printf("[CHANGE] %u -> %d Hz (bridge)\n", usb_rate, rate);
+                usb_rate        = rate;
+                stats.rate      = rate;
+                stats.lrck_rate = rate;
             }
-            /* Append to pre-buffer */
-            snd_pcm_uframes_t to_copy = frames;
-            if (collected + to_copy > prebuf_max_frames)
-                to_copy = prebuf_max_frames - collected;
-            memcpy(prebuf + collected * frame_bytes, cap_buf, to_copy * frame_bytes);
-            collected += to_copy;
-        } else if (frames == -EPIPE) {
-            snd_pcm_prepare(pcm_capture);
-            snd_pcm_start(pcm_capture);
-        } else if (frames < 0) {
-            if (++errors >= MAX_CONSECUTIVE_ERRORS) return -1;
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (now.tv_sec == last_publish || bridge_status(&st) < 0)
+            continue;
+        last_publish = now.tv_sec;
+        stats.write_count      = st.frames;
+        stats.xrun_count       = st.xruns;
+        stats.cap_xrun_count   = st.overruns;
+        stats.cap_frames_total = st.frames;
+        stats.tun              = conf.tun;
+        ctl_socket_publish(&stats);
+
+        if (conf.tun.log_level >= 1 && now.tv_sec - last_status >= 10) {
+            last_status = now.tv_sec;
+            printf("[S] bridge %s %s f=%lu x=%lu o=%lu\n",
+                   st.device, st.state, st.frames, st.xruns, st.overruns);
+            fflush(stdout);
         }
     }
-    return (int)collected;
 }
 
 /* ── Main ─────────────────────────────────────────────────────────── */
 
-int main(void) {
-    char *buffer = NULL;
-    size_t buffer_size = 0;
-    unsigned int current_rate = 0;
-    snd_pcm_uframes_t period_size = PERIOD_FRAMES;
-    int uevent_sock = -1;
+int main(int argc, char **argv) {
     char uevent_buf[UEVENT_BUFFER_SIZE];
     int uac_card = -1;
 
+    router_conf_load(&conf, ROUTER_CONF_FILE);
+
+    /* uac2_router ctl <command...> — talk to a running instance */
+    if (argc > 1 && strcmp(argv[1], "ctl") == 0)
+        return ctl_socket_client(conf.ctl_socket[0] ? conf.ctl_socket : ROUTER_CTL_SOCKET,
+                                 argc - 2, argv + 2);
+
     signal(SIGINT, sighandler);
     signal(SIGTERM, sighandler);
 
-    /* Real-time scheduling */
-    {
-        struct sched_param sp = { .sched_priority = 70 };
-        if (sched_setscheduler(0, SCHED_FIFO, &sp) == 0)
-            printf("[RT] SCHED_FIFO priority %d\n", sp.sched_priority);
-        else
-            fprintf(stderr, "[RT] WARNING: Cannot set SCHED_FIFO: %s\n", strerror(errno));
-    }
+    /* Before RT setup: the control thread must stay SCHED_OTHER */
+    verify_init();
+    audio_bus_init(conf.bus_frames);
+    recorder_init(&conf);
+    /* Players attach through the control socket */
+    play_server_init(conf.ctl_socket[0] ? conf.play_clients : 0, conf.play_frames);
+    ctl_socket_start(conf.ctl_socket, &conf.tun);
+    feedback_init(&conf);
+
+    /* Real-time scheduling: SCHED_FIFO, or SCHED_DEADLINE with a
+     * reservation recomputed on every configure_audio() */
+    rt_sched_init(&conf);
+    cpufreq_policy_init(&conf);
+    if (cpu_load_enabled())
+        load_fd = open(LOAD_FILE, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
     if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
         printf("[RT] Memory locked\n");
 
@@ -365,6 +643,10 @@ int main(void) {
 
     uac_card = find_uac_card();
     if (uac_card < 0) return 1;
+    gadget_status_open(uac_card);   /* before the feedback thread reads it */
+    feedback_attach(uac_card, uac_card_path);
+    gadget_dsd_swap = setup_dsd_swap(conf.dsd_swap_gadget);
+    printf("DSD byte swap: %s\n", gadget_dsd_swap ? "gadget" : "router");
 
     int format_bytes = read_sysfs_int(SYSFS_FORMAT_FILE);
     int channels = read_sysfs_int(SYSFS_CHANNELS_FILE);
@@ -374,204 +656,209 @@ int main(void) {
     }
     printf("UAC2: %d-bit, %d ch\n\n", format_bytes * 8, channels);
 
-    uevent_sock = create_uevent_socket();
-    if (uevent_sock < 0) return 1;
+    if (gadget_event_fd() < 0 && (uevent_sock = create_uevent_socket()) < 0)
+        return 1;
 
     printf("Waiting for rate changes...\n\n");
 
+    set_source_name(SOURCE_USB);
+    stats.usb_priority = conf.usb_priority;
+
     /* Initial rate */
     int rate = read_sysfs_int(SYSFS_RATE_FILE);
-    if (rate > 0) {
+
+    /* BRIDGE=on: the gadget routes, supervise until exit */
+    if (conf.bridge && bridge_start(uac_card_path, I2S_CARD) == 0) {
+        if (rate > 0)
+            usb_rate = stats.rate = stats.lrck_rate = rate;
+        fflush(stdout);
+        supervise_bridge(uevent_buf, sizeof(uevent_buf));
+    } else if (rate > 0) {
         printf("Initial rate: %d Hz\n", rate);
-        if (configure_audio(rate, uac_card, &buffer, &buffer_size, &period_size) == 0)
-            current_rate = rate;
+        usb_rate   = rate;
+        src_rate   = rate;
+        usb_active = 1;
+        configure_audio(rate, uac_card, 1);
     }
 
     /* ── Main loop state ─────────────────────────────────────────── */
 
     const size_t frame_bytes = I2S_CHANNELS * 4;
-    snd_pcm_uframes_t pb_period = playback_period;
-
-    char *accum_buf = malloc(pb_period * frame_bytes);
-    snd_pcm_uframes_t accum_pos = 0;
-
-    /* Pre-buffer for burst-writing to I2S before DMA starts.
-     * 16 playback periods = half of 32768 buffer = ~23 ms at DSD512. */
-    #define PREBUF_PERIODS 16
-    size_t prebuf_max = pb_period * PREBUF_PERIODS;
-    char *prebuf = malloc(prebuf_max * frame_bytes);
-
-    int play_started = 0;
-    int need_prebuffer = 1;  /* Start with pre-buffering phase */
+    int reopened = sinks[0].pcm != NULL;    /* PCMs just (re)configured */
+    enum pc_latency applied_latency = conf.tun.latency;
 
     int consecutive_errors = 0;
-    unsigned long write_count = 0;
-    unsigned long xrun_count = 0;
-    unsigned long cap_xrun_count = 0;
-    unsigned long cap_frames_total = 0;
+    unsigned long routed_frames = 0;
     unsigned long last_status_frames = 0;
 
     fflush(stdout);
 
     while (running) {
-        /* ── Uevent: rate change detection ───────────────────────── */
-        ssize_t len = recv(uevent_sock, uevent_buf, sizeof(uevent_buf) - 1, MSG_DONTWAIT);
-        if (len > 0) {
-            uevent_buf[len] = '\0';
-            if (strstr(uevent_buf, "u_audio") && strstr(uevent_buf, uac_card_name)) {
-                rate = read_sysfs_int(SYSFS_RATE_FILE);
-                if (rate > 0 && rate != (int)current_rate) {
-                    printf("\n[CHANGE] %u -> %u Hz (w=%lu x=%lu)\n",
-                           current_rate, rate, write_count, xrun_count);
-                    if (configure_audio(rate, uac_card, &buffer, &buffer_size, &period_size) == 0) {
-                        current_rate = rate;
-                        pb_period = playback_period;
-                        /* Reallocate accumulation and pre-buffer */
-                        free(accum_buf);
-                        accum_buf = malloc(pb_period * frame_bytes);
-                        accum_pos = 0;
-                        prebuf_max = pb_period * PREBUF_PERIODS;
-                        free(prebuf);
-                        prebuf = malloc(prebuf_max * frame_bytes);
-                        /* Reset counters, enter pre-buffer phase */
-                        play_started = 0;
-                        need_prebuffer = 1;
-                        write_count = 0;
-                        xrun_count = 0;
-                        cap_xrun_count = 0;
-                    }
-                }
+        /* ── Gadget events: rate change detection ────────────────── */
+        rate = usb_rate_changed(uevent_buf, sizeof(uevent_buf));
+        if (rate > 0) {
+            printf("\n[CHANGE] %u -> %u Hz (w=%lu x=%lu)\n",
+                   usb_rate, rate, stats.write_count, stats.xrun_count);
+            usb_rate = rate;
+            if (source == SOURCE_USB) {
+                src_rate = rate;
+                if (configure_audio(rate, uac_card, 1) == 0)
+                    reopened = 1;
+            } else if (open_capture(rate, uac_card) == 0) {
+                printf("[CONFIG] Capture only, %s stays on air\n", stats.source);
             }
         }
 
-        if (!pcm_capture || !pcm_playback) {
+        if (!sinks[0].pcm || (source == SOURCE_USB && !pcm_capture)) {
             usleep(100000);
-            if (current_rate > 0) {
-                printf("[REOPEN] Reconfiguring at %u Hz\n", current_rate);
-                if (configure_audio(current_rate, uac_card, &buffer, &buffer_size, &period_size) == 0) {
-                    pb_period = playback_period;
-                    free(accum_buf);
-                    accum_buf = malloc(pb_period * frame_bytes);
-                    accum_pos = 0;
-                    prebuf_max = pb_period * PREBUF_PERIODS;
-                    free(prebuf);
-                    prebuf = malloc(prebuf_max * frame_bytes);
-                    play_started = 0;
-                    need_prebuffer = 1;
-                    write_count = 0;
-                    xrun_count = 0;
-                    cap_xrun_count = 0;
-                }
+            if (src_rate > 0) {
+                printf("[REOPEN] Reconfiguring at %u Hz\n", src_rate);
+                if (configure_audio(src_rate, uac_card, source == SOURCE_USB || !pcm_capture) == 0)
+                    reopened = 1;
             }
-            continue;
         }
 
-        /* ── Pre-buffer phase: accumulate real data before first write ─ */
-        if (need_prebuffer) {
-            snd_pcm_uframes_t target = pb_period * PREBUF_PERIODS;
-            int got = prebuffer_from_capture(buffer, period_size, pb_period,
-                                             prebuf, prebuf_max, target);
-            if (got < 0) {
-                fprintf(stderr, "[PREBUF] Capture failed, reopening\n");
-                close_pcms();
-                play_started = 0;
-                accum_pos = 0;
-                usleep(500000);
-                continue;
+        /* ── Control socket: changes land here, on a period boundary ─ */
+        unsigned int ctl = ctl_socket_poll(&conf.tun);
+        if (ctl) {
+            if ((ctl & CTL_APPLY_TUNABLES) && conf.tun.latency != applied_latency)
+                ctl |= CTL_APPLY_RECONFIGURE;
+            if (ctl & CTL_APPLY_VERIFY) {
+                verify_reset(conf.tun.verify);
+                verify_get(&stats.verify);
             }
-            /* Burst-write all pre-buffered data to I2S.
-             * DMA auto-starts on first writei; subsequent writes fill the buffer. */
-            snd_pcm_uframes_t written = 0;
-            while (written + pb_period <= (snd_pcm_uframes_t)got) {
-                snd_pcm_sframes_t wr = snd_pcm_writei(pcm_playback,
-                    prebuf + written * frame_bytes, pb_period);
-                if (wr < 0) break;
-                written += wr;
+            for (unsigned int i = 0; i < nsinks; i++)
+                if (sinks[i].pcm) sink_set_prebuffer(&sinks[i], prebuffer_periods());
+            if (sinks[0].pcm)
+                stats.prebuffer_periods = sinks[0].prebuf_target / sinks[0].period;
+            if ((ctl & CTL_APPLY_RECONFIGURE) && src_rate > 0) {
+                printf("[CTL] Reconfiguring at %u Hz, latency %s\n",
+                       src_rate, pc_latency_name(conf.tun.latency));
+                if (configure_audio(src_rate, uac_card, 1) == 0)
+                    reopened = 1;
             }
-            cap_frames_total += got;
-            need_prebuffer = 0;
-            play_started = 1;
-            last_status_frames = cap_frames_total;  /* Defer first STAT */
-            continue;
         }
 
-        /* ── Steady state: capture → byte-swap → accumulate → write ── */
-        snd_pcm_sframes_t frames = snd_pcm_readi(pcm_capture, buffer, period_size);
+        /* ── Arbitration: highest-priority ready source goes on air ─ */
+        unsigned int want_rate;
+        int want = arbitrate(&want_rate);
+        if (want != source && switch_source(want, want_rate, uac_card) == 0 && sinks[0].pcm)
+            reopened = 1;
+
+        if (reopened) {
+            /* Sinks start in their pre-buffer phase; reset counters */
+            reopened = 0;
+            applied_latency = conf.tun.latency;
+            stats.cap_xrun_count = 0;
+            sinks_stats();
+            stats.tun = conf.tun;
+            ctl_socket_publish(&stats);
+        }
+
+        if (!sinks[0].pcm)
+            continue;
+
+        /* ── Source → byte-swap + meter → sinks (accumulate, pre-buffer, write) ─ */
+        snd_pcm_sframes_t frames;
+
+        if (source == SOURCE_USB) {
+            if (!pcm_capture)
+                continue;
+            /* With players attached, a silent host must not hold the loop */
+            if (play_server_enabled() && pcm_io_wait(pcm_capture, USB_IDLE_MS) == 0) {
+                usb_active = 0;
+                continue;
+            }
+            frames = pcm_io_readi(pcm_capture, buffer, src_period);
+            if (frames > 0) {
+                usb_active = 1;
+                stats.cap_frames_total += frames;
+            }
+        } else {
+            watch_usb();
+            /* Short ring: wait up to two periods, then let the sink underrun */
+            frames = play_server_read(source, buffer, src_period,
+                                      (int)(src_period * 2000 / stats.lrck_rate) + 1);
+            if (frames <= 0)
+                continue;               /* starved or retired: re-arbitrate */
+        }
 
         if (frames > 0) {
             consecutive_errors = 0;
-            cap_frames_total += frames;
-
-            /* DSD byte-swap */
-            if (is_current_dsd) {
-                uint32_t *w = (uint32_t *)buffer;
-                size_t nwords = frames * I2S_CHANNELS;
-                for (size_t i = 0; i < nwords; i++)
-                    w[i] = BSWAP32(w[i]);
+            routed_frames += frames;
+            recorder_push(RECORDER_PRE, buffer, frames * frame_bytes);
+            verify_push(VERIFY_PRE, buffer, frames);
+
+            /* DSD byte-swap and metering in one pass (meter.h), or
+             * metering only if the gadget swapped in its copy */
+            if (is_current_dsd && source == SOURCE_USB && gadget_dsd_swap)
+                meter_dsd((const uint32_t *)buffer, frames, &stats.meter);
+            else if (is_current_dsd)
+                meter_dsd_swap((uint32_t *)buffer, frames, &stats.meter);
+            else
+                meter_pcm((const int32_t *)buffer, frames, &stats.meter);
+
+            /* Publish the post-swap period to bus consumers (one copy) */
+            audio_bus_write(buffer, frames);
+            recorder_push(RECORDER_POST, buffer, frames * frame_bytes);
+            verify_push(VERIFY_POST, buffer, frames);
+            if (conf.tun.verify)
+                verify_get(&stats.verify);
+
+            int res = sink_feed(&sinks[0], (const uint8_t *)buffer, frames);
+            if (res == SINK_STARTED) {
+                last_status_frames = routed_frames;  /* Defer first STAT */
+                cpu_load_reset();
+                feedback_hold();
+            } else if (res == SINK_XRUN) {
+                period_missed();
+                feedback_hold();
+            } else if (res == SINK_FAILED) {
+                close_pcms();
+                continue;
             }
-
-            /* Accumulate into full playback periods */
-            snd_pcm_uframes_t src_off = 0;
-            snd_pcm_uframes_t remaining = frames;
-
-            while (remaining > 0) {
-                snd_pcm_uframes_t to_copy = remaining;
-                if (accum_pos + to_copy > pb_period)
-                    to_copy = pb_period - accum_pos;
-                memcpy(accum_buf + accum_pos * frame_bytes,
-                       buffer + src_off * frame_bytes, to_copy * frame_bytes);
-                accum_pos += to_copy;
-                src_off += to_copy;
-                remaining -= to_copy;
-
-                if (accum_pos >= pb_period) {
-                    snd_pcm_sframes_t wr = snd_pcm_writei(pcm_playback, accum_buf, pb_period);
-                    accum_pos = 0;
-
-                    if (wr > 0) {
-                        write_count++;
-                    } else if (wr == -EPIPE) {
-                        /* XRUN recovery: re-enter pre-buffer phase */
-                        xrun_count++;
-                        fprintf(stderr, "[XRUN] Playback underrun #%lu at w=%lu\n", xrun_count, write_count);
-                        snd_pcm_prepare(pcm_playback);
-                        need_prebuffer = 1;
-                        play_started = 0;
-                        break;
-                    } else if (wr == -ENODEV || wr == -EBADF) {
-                        close_pcms();
-                        play_started = 0;
-                        break;
-                    }
+            /* Secondary sinks never block and never take the primary down */
+            for (unsigned int i = 1; i < nsinks; i++) {
+                if (sink_feed(&sinks[i], (const uint8_t *)buffer, frames) == SINK_FAILED) {
+                    fprintf(stderr, "[SINK] %s: device gone, offline\n", sinks[i].name);
+                    sink_close(&sinks[i]);
                 }
             }
-
-
-            /* Status log disabled to reduce spam */
-            /* if (cap_frames_total - last_status_frames >= current_rate / 32 * 10) {
-                last_status_frames = cap_frames_total;
-                printf("[S] w=%lu x=%lu cx=%lu cf=%lu\n",
-                       write_count, xrun_count, cap_xrun_count, cap_frames_total);
+            sinks_stats();
+
+            /* Fill through the router → gadget feedback (feedback.h) */
+            if (source == SOURCE_USB && !sinks[0].prebuffering)
+                feedback_update(pcm_capture, sinks[0].pcm, frames);
+
+            /* Status line only on request (LOG>=1) — UART printf costs ~4 ms */
+            if (conf.tun.log_level >= 1 &&
+                routed_frames - last_status_frames >= stats.lrck_rate * 10UL) {
+                last_status_frames = routed_frames;
+                printf("[S] %s w=%lu x=%lu cx=%lu cf=%lu\n", stats.source,
+                       stats.write_count, stats.xrun_count, stats.cap_xrun_count,
+                       stats.cap_frames_total);
                 fflush(stdout);
-            } */
+            }
+
+            account_period();
         } else if (frames == -EPIPE) {
-            cap_xrun_count++;
-            fprintf(stderr, "[XRUN] Capture overrun #%lu\n", cap_xrun_count);
-            accum_pos = 0;
-            snd_pcm_prepare(pcm_capture);
-            snd_pcm_start(pcm_capture);
+            stats.cap_xrun_count++;
+            fprintf(stderr, "[XRUN] Capture overrun #%lu\n", stats.cap_xrun_count);
+            verify_gap();
+            for (unsigned int i = 0; i < nsinks; i++)
+                sink_discard_partial(&sinks[i]);
+            pcm_io_prepare(pcm_capture);
+            pcm_io_start(pcm_capture);
+            period_missed();
+            feedback_hold();
         } else if (frames == -ENODEV || frames == -EBADF) {
             close_pcms();
-            play_started = 0;
-            accum_pos = 0;
             usleep(500000);
         } else if (frames < 0) {
             if (++consecutive_errors >= MAX_CONSECUTIVE_ERRORS) {
                 fprintf(stderr, "[ERROR] Too many capture errors (last=%ld), reopening\n", (long)frames);
                 close_pcms();
                 consecutive_errors = 0;
-                play_started = 0;
-                accum_pos = 0;
                 usleep(500000);
             }
         }
@@ -579,12 +866,19 @@ int main(void) {
 
     /* ── Cleanup ──────────────────────────────────────────────────── */
 
-    free(accum_buf);
-    free(prebuf);
     free(buffer);
     if (uevent_sock >= 0) close(uevent_sock);
+    bridge_stop();
     close_pcms();
-
-    printf("\nStopped (w=%lu x=%lu)\n", write_count, xrun_count);
+    cpufreq_policy_exit();
+    feedback_exit();
+    gadget_status_close();
+    ctl_socket_stop();
+    play_server_exit();
+    recorder_stop();
+    audio_bus_exit();
+    if (load_fd >= 0) { close(load_fd); unlink(LOAD_FILE); }
+
+    printf("\nStopped (w=%lu x=%lu)\n", stats.write_count, stats.xrun_count);
     return 0;
 }
@@ -0,0 +1,83 @@
+/*
+ * Bit-perfect verification — see verify.h
+ */
+
+#include <string.h>
+
+#include "verify.h"
+#include "crc32.h"
+
+#define FRAME_BYTES 8       /* 2 ch × 32 bit */
+
+struct verify_stream {
+    int started;
+    uint32_t crc_all;               /* includes trailing zero frames */
+    unsigned long long frames_all;
+    struct verify_span committed;   /* at the last non-zero frame */
+};
+
+static struct verify_stream streams[2];
+static int active;
+static unsigned long gaps;
+
+void verify_init(void) {
+    crc32_init();
+}
+
+void verify_reset(int on) {
+    memset(streams, 0, sizeof(streams));
+    active = on;
+    gaps   = 0;
+}
+
+static int frame_zero(const uint8_t *f) {
+    uint32_t l, r;
+    memcpy(&l, f, 4);
+    memcpy(&r, f + 4, 4);
+    return (l | r) == 0;
+}
+
+void verify_push(int stream, const void *data, unsigned long frames) {
+    struct verify_stream *vs = &streams[stream];
+    const uint8_t *p = data;
+    unsigned long first = 0, last;
+
+    if (!active || !frames) return;
+
+    if (!vs->started) {
+        while (first < frames && frame_zero(p + first * FRAME_BYTES))
+            first++;
+        vs->committed.skipped += first;
+        if (first == frames) return;
+        vs->started = 1;
+    }
+
+    /* last non-zero frame + 1; equals `first` when the rest is silence */
+    last = frames;
+    while (last > first && frame_zero(p + (last - 1) * FRAME_BYTES))
+        last--;
+
+    if (last > first) {
+        vs->crc_all = crc32_update(vs->crc_all, p + first * FRAME_BYTES,
+                                   (last - first) * FRAME_BYTES);
+        vs->frames_all += last - first;
+        vs->committed.crc    = vs->crc_all;
+        vs->committed.frames = vs->frames_all;
+    }
+    if (frames > last) {
+        vs->crc_all = crc32_update(vs->crc_all, p + last * FRAME_BYTES,
+                                   (frames - last) * FRAME_BYTES);
+        vs->frames_all += frames - last;
+    }
+}
+
+void verify_gap(void) {
+    if (active) gaps++;
+}
+
+void verify_get(struct verify_stats *out) {
+    out->active  = active;
+    out->gaps    = gaps;
+    out->span[VERIFY_PRE]  = streams[VERIFY_PRE].committed;
+    out->span[VERIFY_POST] = streams[VERIFY_POST].committed;
+}
@@ -0,0 +1,49 @@
+/*
+ * Bit-perfect verification — running CRC-32 of the routed streams
+ *
+ *   pre   capture data exactly as received from the gadget
+ *         (checks the u_audio frame-alignment guard and USB transfer)
+ *   post  the stream handed to the sinks, after the DSD byte swap
+ *
+ * Each stream is hashed over its "span": leading all-zero frames (the
+ * silence before the player starts) are skipped and trailing all-zero
+ * frames are only counted once more signal follows, so the result is
+ * the CRC of exactly what the player sent.  uac2_testsig gen/crc print
+ * the values to expect for a file.  The I2S driver's copy_user stage
+ * is after this point and needs an external capture + uac2_testsig
+ * check.
+ *
+ * Enabled with VERIFY=on or "ctl verify start", costs one CRC pass per
+ * stream (slice-by-8, crc32.h) in the audio thread.
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdint.h>
+
+#define VERIFY_PRE      0
+#define VERIFY_POST     1
+
+struct verify_span {
+    uint32_t crc;                   /* CRC-32 of `frames` frames */
+    unsigned long long frames;      /* up to the last non-zero frame */
+    unsigned long long skipped;     /* leading zero frames */
+};
+
+struct verify_stats {
+    int active;
+    unsigned long gaps;             /* capture overruns while verifying */
+    struct verify_span span[2];     /* VERIFY_PRE, VERIFY_POST */
+};
+
+/* Startup, before real-time: builds the CRC tables */
+void verify_init(void);
+
+/* Audio thread */
+void verify_reset(int active);
+void verify_push(int stream, const void *data, unsigned long frames);
+void verify_gap(void);
+void verify_get(struct verify_stats *out);
+
+#endif /* VERIFY_H */
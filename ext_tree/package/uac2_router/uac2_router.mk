@@ -4,20 +4,62 @@
 #
 ################################################################################
 
-UAC2_ROUTER_VERSION = 2.3
+UAC2_ROUTER_VERSION = 2.4
 UAC2_ROUTER_SITE = $(TOPDIR)/../ext_tree/package/uac2_router/src
 UAC2_ROUTER_SITE_METHOD = local
 UAC2_ROUTER_LICENSE = MIT
 UAC2_ROUTER_LICENSE_FILES = LICENSE
-UAC2_ROUTER_DEPENDENCIES = alsa-lib
+UAC2_ROUTER_DEPENDENCIES = alsa-lib libpurecore
+
+# The toolchain defaults to vfpv4-d16; the Cortex-A7 has NEON, which
+# the fused metering / DSD swap pass (meter.c) uses; the shared kernels
+# live in libpurecore
+ifeq ($(BR2_ARM_CPU_HAS_NEON),y)
+UAC2_ROUTER_CFLAGS = -mfpu=neon-vfpv4
+endif
+
+ifeq ($(BR2_PACKAGE_UAC2_ROUTER_TOOLS),y)
+define UAC2_ROUTER_BUILD_TOOLS
+	$(TARGET_CC) $(TARGET_CFLAGS) -Wall -I$(@D) -o $(@D)/uac2_pcm_bench \
+		$(@D)/bench/pcm_bench.c $(TARGET_LDFLAGS) -lpurecore -lasound
+	$(TARGET_CC) $(TARGET_CFLAGS) -Wall -I$(@D) -o $(@D)/uac2_bus_cat \
+		$(@D)/tools/bus_cat.c $(TARGET_LDFLAGS)
+	$(TARGET_CC) $(TARGET_CFLAGS) -Wall -I$(@D) -o $(@D)/uac2_testsig \
+		$(@D)/tools/testsig.c $(@D)/crc32.c $(@D)/verify.c $(TARGET_LDFLAGS)
+endef
+define UAC2_ROUTER_INSTALL_TOOLS
+	$(INSTALL) -D -m 0755 $(@D)/uac2_pcm_bench $(TARGET_DIR)/usr/bin/uac2_pcm_bench
+	$(INSTALL) -D -m 0755 $(@D)/uac2_bus_cat $(TARGET_DIR)/usr/bin/uac2_bus_cat
+	$(INSTALL) -D -m 0755 $(@D)/uac2_testsig $(TARGET_DIR)/usr/bin/uac2_testsig
+endef
+endif
 
 define UAC2_ROUTER_BUILD_CMDS
-	$(TARGET_CC) $(TARGET_CFLAGS) -Wall -o $(@D)/uac2_router $(@D)/uac2_router.c $(TARGET_LDFLAGS) -lasound -lpthread
+	$(TARGET_CC) $(TARGET_CFLAGS) $(UAC2_ROUTER_CFLAGS) -Wall -o $(@D)/uac2_router $(@D)/*.c $(TARGET_LDFLAGS) -lpurecore -lasound -lpthread -lm
+	$(TARGET_CC) $(TARGET_CFLAGS) -Wall -I$(@D) -o $(@D)/uac2_play $(@D)/tools/play.c $(TARGET_LDFLAGS)
+	$(UAC2_ROUTER_BUILD_TOOLS)
 endef
 
 define UAC2_ROUTER_INSTALL_TARGET_CMDS
 	$(INSTALL) -D -m 0755 $(@D)/uac2_router $(TARGET_DIR)/usr/bin/uac2_router
+	$(INSTALL) -D -m 0755 $(@D)/uac2_play $(TARGET_DIR)/usr/bin/uac2_play
 	$(INSTALL) -D -m 0755 $(@D)/S99uac2_router $(TARGET_DIR)/etc/init.d/S99uac2_router
+	$(INSTALL) -D -m 0644 $(@D)/uac2_router.conf $(TARGET_DIR)/etc/uac2_router.conf
+	$(UAC2_ROUTER_INSTALL_TOOLS)
+endef
+
+# Host side: "make host-uac2_router" → $(HOST_DIR)/bin/uac2_testsig,
+# the bit-perfect test signal generator/checker for the playing machine
+HOST_UAC2_ROUTER_DEPENDENCIES =
+
+define HOST_UAC2_ROUTER_BUILD_CMDS
+	$(HOSTCC) $(HOST_CFLAGS) -Wall -I$(@D) -o $(@D)/uac2_testsig \
+		$(@D)/tools/testsig.c $(@D)/crc32.c $(@D)/verify.c $(HOST_LDFLAGS)
+endef
+
+define HOST_UAC2_ROUTER_INSTALL_CMDS
+	$(INSTALL) -D -m 0755 $(@D)/uac2_testsig $(HOST_DIR)/bin/uac2_testsig
 endef
 
 $(eval $(generic-package))
+$(eval $(host-generic-package))